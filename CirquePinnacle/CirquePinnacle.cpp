@@ -7,6 +7,7 @@
  * My driver is quite simple compared to Ryan's. If you want to see more
  * comprehensive utilization of the hardware, please visit his repo.
  *
+ * 2026-10-17 - Added ISR data callback.
  * 2022-12-10 - Added interrupt capability.
  * 2022-12-06 - Original.
  ****************************************************************************/
@@ -220,6 +221,7 @@ cp_error_t CirquePinnacle::Start_ISR(uint8_t pin_addr, trackpad_data_t& trackpad
   isr_data[my_isr_num].trackpad_data_p = &trackpadData; // pointer to caller's data store
   isr_data[my_isr_num].isr_in_use = true;       // this ISR data is in use
   isr_data[my_isr_num].data_ready = false;      // set when the ISR has populated user data
+  isr_data[my_isr_num].data_cb = data_cb;       // optional user callback
   Set_RAP_Callbacks(my_isr_num);                // child object sets the RAP callbacks in the ISR data
   isr_in_use = true;                            // check this data_ready flag
   voidFuncPtr theISR;
@@ -253,6 +255,18 @@ void CirquePinnacle::End_ISR(void) {
   }
 }
 
+// Set a function for the ISR to call with each decoded report, e.g. to
+// fill a PlotSnapshot. It runs in interrupt context. May be called before
+// or after Start_ISR(); nullptr removes it.
+void CirquePinnacle::Set_ISR_Callback(cp_data_f callback) {
+  data_cb = callback;
+  if (isr_in_use) {
+    noInterrupts();   // a pointer isn't written atomically on 8-bit MCUs
+    isr_data[my_isr_num].data_cb = callback;
+    interrupts();
+  }
+}
+
 // Clear the Data Ready flag set by the ISR.
 //  The Cirque's DR indicators are cleared by the ISR
 void CirquePinnacle::Clear_DR(void) {
@@ -294,6 +308,7 @@ void CirquePinnacle::Read_Data_ISR(uint8_t myISRnum) {
   // populate the users data structure
   Decode_Data(raw_data, data_len, *isr_data[myISRnum].trackpad_data_p);
   isr_data[myISRnum].data_ready = true;
+  if (isr_data[myISRnum].data_cb) isr_data[myISRnum].data_cb(*isr_data[myISRnum].trackpad_data_p);
 }
 
 // ISR callbacks bound to an index (MAX_ISRS)
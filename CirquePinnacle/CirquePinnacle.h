@@ -7,6 +7,7 @@
  * My driver is quite simple compared to Ryan's. If you want to see more
  * comprehensive utilization of the hardware, please visit his repo.
  *
+ * 2026-10-17 - Added ISR data callback.
  * 2023-01-10 - Fixed isr_data.spi_speed size (!).
  * 2022-12-10 - Added interrupt capability.
  * 2022-12-06 - Original.
@@ -172,6 +173,7 @@ typedef struct {
 
 typedef void (*rap_read_f) (uint8_t isr_number, pinnacle_register_t register_addr, uint8_t* data, uint8_t count);
 typedef void (*rap_write_f)(uint8_t isr_number, pinnacle_register_t register_addr, uint8_t data);
+typedef void (*cp_data_f)  (const trackpad_data_t& trackpad_data);  // runs in the ISR
 
 typedef struct _isr_data_t {
   uint8_t  pin_addr;        // the SPI select pin or I2C address of device to read
@@ -182,6 +184,7 @@ typedef struct _isr_data_t {
   bool     data_ready;      // signal fresh data
   rap_read_f  rap_read_cb;  // RAP read callback
   rap_write_f rap_write_cb; // rap_write callback
+  cp_data_f   data_cb;      // optional user callback with the decoded data
   bool     isr_in_use;      // this dataset is in use by ISR
 } isr_data_t;
 
@@ -211,6 +214,7 @@ class CirquePinnacle {
   int8_t  data_ready_pin; // the gpio pin wired to the trackpad's HW_DR line
   bool    isr_in_use;     // ISR active, read its data ready flag
   uint8_t my_isr_num = -1; // index into the isr_data table for this instance
+  cp_data_f data_cb = nullptr; // handed to the ISR by Start_ISR()
 
   virtual
   void Set_RAP_Callbacks(uint8_t isr_number) = 0; // child classes set their callback pointers
@@ -250,6 +254,7 @@ public:
   // Interrupt Service Routines
   cp_error_t Start_ISR(uint8_t pin_address, trackpad_data_t& trackpadData);
   void End_ISR(void);
+  void Set_ISR_Callback(cp_data_f callback); // before or after Start_ISR(); keep it short
   void Clear_DR(void);
 
   /*
@@ -12,6 +12,8 @@
  * and Cirque for example cade and inspiration.
  *
  * 2022-12-11 - Original.
+ * 2026-10-17 - Plot's throttle() fits the frames to the 9600 baud link.
+ * 2026-10-17 - Warns once if a frame overflows Plot's buffer.
  ****************************************************************************/
 
 // Select the interface being used
@@ -58,6 +60,9 @@ Plot plot; // instantiate
 void setup(void) {
   Serial.begin(9600);
   while (not Serial and millis() < 10e3); // wait up to 10secs for an open Console
+  // the trackpad reports faster than 9600 baud can carry - send what fits,
+  // every 2nd or 3rd frame, instead of stalling loop() on Serial
+  plot.throttle(9600 / 10);
   setMyConfigVars();  // set my configuration parameters before begin() is called
 #ifdef USING_SPI
   trackpad1.begin(TP1_DATA_READY_PIN, TP1_SPI_SELECT_PIN, CP_SPI_SPEED);
@@ -126,6 +131,14 @@ void plot_trackpad_data(trackpad_data_t& trackpadData) {
     plot.add("Ba", button_value(trackpadData, PINNACLE_FLG_REL_BUTTON_AUXILLARY, 25));
   }
   plot.print(Serial);
+
+  // series that don't fit in the frame buffer are dropped, not sent - if
+  // you add more, check overflows() and raise PLOT_CAPACITY to suit
+  static bool warned = false;
+  if (plot.overflows() and not warned) {
+    Serial << "plot frame overflow - #define PLOT_CAPACITY larger" << endl;
+    warned = true;
+  }
 }
 
 // just read and print chip and firmware info
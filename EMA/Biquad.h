@@ -0,0 +1,222 @@
+/*!
+ *  @file Biquad.h
+ *
+ *  @section intro_sec Introduction
+ *
+ *  Second-order IIR filter sections, alone (Biquad) or cascaded
+ *  (SOSCascade<N>) for steeper responses than an EMA, which is a
+ *  first-order low-pass. Each section is direct form II transposed:
+ *
+ *    y  = b0 x + s1
+ *    s1 = b1 x - a1 y + s2
+ *    s2 = b2 x - a2 y
+ *
+ *  The float kernel works in float; the Q15 kernel takes int16_t samples,
+ *  Q28 coefficients and 64-bit state, so low cut-offs (a1 near -2) keep
+ *  their precision, and feeds the output back at 30 bits. Design helpers
+ *  fill in Butterworth low-pass and high-pass, or notch, coefficients at
+ *  setup time. A cascade can carry several channels with the same
+ *  coefficients, e.g., accel X, Y and Z, and update them all from one
+ *  vector.
+ *
+ *  @section usage Usage
+ *
+ *  SOSCascade<2> lp;                   // 4th order
+ *  lp.lowpass(20, 1000);               // Butterworth, 20 Hz at 1 kHz
+ *  float y = lp.update(x);
+ *
+ *  SOSCascade<1, float, 3> accel;      // one biquad, 3 channels
+ *  accel.lowpass(50, 1000);
+ *  accel.update(raw_xyz, smooth_xyz);
+ *
+ *  Biquad_Q15 hum;
+ *  hum.notch(60, 1000, 10);
+ *  int16_t z = hum.update(raw_z);
+ *
+ * 	@section  HISTORY
+ *
+ *  20261017  John Jordan - Original.
+ */
+
+#ifndef BIQUAD_H
+#define BIQUAD_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "EMA.h"
+
+// one section's coefficients, normalized so a0 = 1
+struct biquad_coefs {
+  float b0, b1, b2, a1, a2;
+};
+
+/*
+ * Design helpers, from the Audio EQ Cookbook (R. Bristow-Johnson).
+ * fc is the cut-off or notch frequency and fs the sample rate, in the
+ * same units; q = 0.7071 gives a Butterworth section.
+ */
+inline biquad_coefs biquad_design (double b0, double b1, double b2, double a0, double a1, double a2) {
+  biquad_coefs c = { float(b0 / a0), float(b1 / a0), float(b2 / a0), float(a1 / a0), float(a2 / a0) };
+  return c;
+}
+
+inline biquad_coefs biquad_lowpass (float fc, float fs, float q=0.7071068f) {
+  double w0 = 2 * M_PI * fc / fs, cw = cos(w0), alpha = sin(w0) / (2 * q);
+  return biquad_design((1 - cw) / 2, 1 - cw, (1 - cw) / 2, 1 + alpha, -2 * cw, 1 - alpha);
+}
+
+inline biquad_coefs biquad_highpass (float fc, float fs, float q=0.7071068f) {
+  double w0 = 2 * M_PI * fc / fs, cw = cos(w0), alpha = sin(w0) / (2 * q);
+  return biquad_design((1 + cw) / 2, -(1 + cw), (1 + cw) / 2, 1 + alpha, -2 * cw, 1 - alpha);
+}
+
+// q is f0 over the -3 dB bandwidth: higher is narrower
+inline biquad_coefs biquad_notch (float f0, float fs, float q) {
+  double w0 = 2 * M_PI * f0 / fs, cw = cos(w0), alpha = sin(w0) / (2 * q);
+  return biquad_design(1, -2 * cw, 1, 1 + alpha, -2 * cw, 1 - alpha);
+}
+
+// Q of section i of an order 2n Butterworth filter
+inline float butterworth_q (size_t n, size_t i) {
+  return float(1 / (2 * sin((2 * i + 1) * M_PI / (4 * n))));
+}
+
+// the types and arithmetic behind SOSCascade<N, T>
+template <typename T> struct biquad_traits;
+
+template <> struct biquad_traits<float> {
+  typedef float sample_t;
+  typedef float coef_t;
+  typedef float state_t;
+  static coef_t coef (float c) { return c; }
+  static float to_float (coef_t c) { return c; }
+  static state_t state (float v) { return v; }   // v in sample units
+  static sample_t step (const coef_t* c, state_t& s1, state_t& s2, sample_t x) {
+    sample_t y = c[0] * x + s1;
+    s1 = c[1] * x - c[3] * y + s2;
+    s2 = c[2] * x - c[4] * y;
+    return y;
+  }
+};
+
+template <> struct biquad_traits<Q15> {
+  typedef int16_t sample_t;
+  typedef int32_t coef_t;   // Q28, |c| < 8
+  typedef int64_t state_t;  // sample x coef, Q15 x Q28
+  static coef_t coef (float c) { return coef_t(double(c) * 268435456.0 + (c < 0 ? -0.5 : 0.5)); }
+  static float to_float (coef_t c) { return c * (1.0f / 268435456.0f); }
+  static state_t state (float v) { return state_t(double(v) * 268435456.0); }
+  // the output is rounded to int16_t, but fed back as Q30: near DC the
+  // poles amplify a rounded feedback term hundreds of times
+  static sample_t step (const coef_t* c, state_t& s1, state_t& s2, sample_t x) {
+    int64_t acc = int64_t(c[0]) * x + s1;
+    int64_t y30 = acc >> 13;
+    if (y30 > 2147483647) y30 = 2147483647;
+    if (y30 < -2147483647 - 1) y30 = -2147483647 - 1;
+    s1 = int64_t(c[1]) * x - ((int64_t(c[3]) * y30) >> 15) + s2;
+    s2 = int64_t(c[2]) * x - ((int64_t(c[4]) * y30) >> 15);
+    return ema_traits<Q15>::saturate(int32_t((acc + (1L << 27)) >> 28));
+  }
+};
+
+/*
+ * N cascaded biquad sections, with the same coefficients for each of
+ * CHANNELS independent channels.
+ */
+template <size_t N, typename T=float, size_t CHANNELS=1>
+class SOSCascade {
+
+ public:
+
+  typedef typename biquad_traits<T>::sample_t sample_t;
+
+  // c'tor - pass-through until coefficients are set
+  SOSCascade (void) {
+    biquad_coefs unity = { 1, 0, 0, 0, 0 };
+    for (size_t i=0 ; i<N ; i++) set(i, unity);
+    reset();
+  }
+
+  // set one section's coefficients
+  void set (size_t section, const biquad_coefs& bc) {
+    coef_t* c = k[section];
+    c[0] = traits::coef(bc.b0);
+    c[1] = traits::coef(bc.b1);
+    c[2] = traits::coef(bc.b2);
+    c[3] = traits::coef(bc.a1);
+    c[4] = traits::coef(bc.a2);
+  }
+
+  // order 2N Butterworth low-pass or high-pass at fc, sample rate fs
+  void lowpass (float fc, float fs) {
+    for (size_t i=0 ; i<N ; i++) set(i, biquad_lowpass(fc, fs, butterworth_q(N, i)));
+  }
+
+  void highpass (float fc, float fs) {
+    for (size_t i=0 ; i<N ; i++) set(i, biquad_highpass(fc, fs, butterworth_q(N, i)));
+  }
+
+  // every section notches f0, for a deeper, wider notch as N grows
+  void notch (float f0, float fs, float q) {
+    for (size_t i=0 ; i<N ; i++) set(i, biquad_notch(f0, fs, q));
+  }
+
+  // settle every channel as if the input had been x forever, so the
+  // output starts at the filter's DC response to x instead of ringing up
+  void reset (sample_t x=0) {
+    float y = x;
+    for (size_t i=0 ; i<N ; i++) {
+      const coef_t* c = k[i];
+      float b0 = traits::to_float(c[0]), b1 = traits::to_float(c[1]), b2 = traits::to_float(c[2]);
+      float a1 = traits::to_float(c[3]), a2 = traits::to_float(c[4]);
+      float den = 1 + a1 + a2;
+      float in = y;
+      y = den != 0 ? in * (b0 + b1 + b2) / den : 0;
+      state_t v2 = traits::state(b2 * in - a2 * y);
+      state_t v1 = traits::state(b1 * in - a1 * y + b2 * in - a2 * y);
+      for (size_t ch=0 ; ch<CHANNELS ; ch++) {
+        s1[i][ch] = v1;
+        s2[i][ch] = v2;
+      }
+    }
+  }
+
+  // filter one sample of one channel
+  sample_t update (sample_t x, size_t channel=0) {
+    for (size_t i=0 ; i<N ; i++) x = traits::step(k[i], s1[i][channel], s2[i][channel], x);
+    return x;
+  }
+
+  // filter one sample of every channel, in[0..CHANNELS-1] to out; in and
+  // out may be the same array
+  void update (const sample_t* in, sample_t* out) {
+    for (size_t ch=0 ; ch<CHANNELS ; ch++) out[ch] = in[ch];
+    for (size_t i=0 ; i<N ; i++) {
+      const coef_t* c = k[i];
+      for (size_t ch=0 ; ch<CHANNELS ; ch++) out[ch] = traits::step(c, s1[i][ch], s2[i][ch], out[ch]);
+    }
+  }
+
+  // filter n frames of CHANNELS interleaved samples
+  void update (const sample_t* in, size_t n, sample_t* out) {
+    for (size_t f=0 ; f<n ; f++) update(in + f * CHANNELS, out + f * CHANNELS);
+  }
+
+  static size_t sections (void) { return N; }
+  static size_t channels (void) { return CHANNELS; }
+
+ protected:
+
+  typedef biquad_traits<T> traits;
+  typedef typename traits::coef_t  coef_t;
+  typedef typename traits::state_t state_t;
+
+  coef_t  k[N][5];              // b0 b1 b2 a1 a2 per section
+  state_t s1[N][CHANNELS], s2[N][CHANNELS];
+}; // class SOSCascade
+
+typedef SOSCascade<1>      Biquad;
+typedef SOSCascade<1, Q15> Biquad_Q15;
+
+#endif /* _H */
@@ -22,6 +22,12 @@
  *
  * 	@section  HISTORY
  *
+ *  20261017  John Jordan - Added state snapshots: save(), restore().
+ *  20261017  John Jordan - Warm-up averaging keeps a running sum, optionally
+ *            compensated.
+ *  20261017  John Jordan - Added batch update().
+ *  20261017  John Jordan - Templated on sample type as BasicEMA<T>, with
+ *            Q15/Q31 fixed-point versions. EMA is BasicEMA<float>.
  *  20220516  John Jordan - Periods and samples are now unsigned ints.
  *  20220512  John Jordan - Added accessors for number of periods.
  *  20190828  John Jordan - Original.
@@ -31,16 +37,18 @@
 
 /**************************************************************************/
 /*!
-    @brief  Instantiates a new MPU6050 class
+    @brief  Instantiates a new EMA class
     @param  n_periods
             number of periods used in EMA calculations
     @param  samples_to_avg
             number of samples to be averaged to set initial EMA value
  */
 /**************************************************************************/
-EMA::EMA (U_INT n_periods, U_INT samples_to_avg) {
+template <typename T>
+BasicEMA<T>::BasicEMA (U_INT n_periods, U_INT samples_to_avg) {
   setPeriods(n_periods);
   samples_to_average = samples_to_avg;
+  warmup.clear();
 }
 
 /**************************************************************************/
@@ -51,25 +59,71 @@ EMA::EMA (U_INT n_periods, U_INT samples_to_avg) {
     @returns New EMA
 */
 /**************************************************************************/
-float EMA::update(float sample) {
+template <typename T>
+typename BasicEMA<T>::sample_t BasicEMA<T>::update(sample_t sample) {
   if (averaging_done) {
-    ema_value = k * sample + k2 * ema_value;
+    // ema + k(sample - ema): one multiply, and exact at k = 1
+    ema_value = ema_traits<T>::step(ema_value, sample, k);
   } else {
-    // recover sum, add new value ; save new average
-    ema_value  = (ema_value * averaged_samples) + sample;
-    ema_value /= ++averaged_samples;
+    ema_value = warmup.add(sample, ++averaged_samples);
     averaging_done = (averaged_samples >= samples_to_average);
   }
   return ema_value;
 }
 
+/**************************************************************************/
+/*!
+    @brief  Update the EMA with a block of samples, oldest first. Warm-up
+            averaging runs sample by sample; the rest runs in an unrolled
+            loop with the EMA held in a local, with the same arithmetic
+            and results as calling update(sample) for each sample.
+    @param  samples
+            the samples to apply
+    @param  n
+            number of samples
+    @param  out
+            where to write the EMA after each sample, or nullptr
+    @returns New EMA
+*/
+/**************************************************************************/
+template <typename T>
+typename BasicEMA<T>::sample_t BasicEMA<T>::update(const sample_t* samples, size_t n, sample_t* out) {
+  size_t i = 0;
+  for ( ; i < n and not averaging_done ; i++) {
+    sample_t v = update(samples[i]);
+    if (out) out[i] = v;
+  }
+  sample_t y = ema_value;
+  const coef_t kk = k;
+  if (out) {
+    for ( ; i + 4 <= n ; i += 4) {
+      out[i]     = y = ema_traits<T>::step(y, samples[i],     kk);
+      out[i + 1] = y = ema_traits<T>::step(y, samples[i + 1], kk);
+      out[i + 2] = y = ema_traits<T>::step(y, samples[i + 2], kk);
+      out[i + 3] = y = ema_traits<T>::step(y, samples[i + 3], kk);
+    }
+    for ( ; i<n ; i++) out[i] = y = ema_traits<T>::step(y, samples[i], kk);
+  } else {
+    for ( ; i + 4 <= n ; i += 4) {
+      y = ema_traits<T>::step(y, samples[i],     kk);
+      y = ema_traits<T>::step(y, samples[i + 1], kk);
+      y = ema_traits<T>::step(y, samples[i + 2], kk);
+      y = ema_traits<T>::step(y, samples[i + 3], kk);
+    }
+    for ( ; i<n ; i++) y = ema_traits<T>::step(y, samples[i], kk);
+  }
+  ema_value = y;
+  return ema_value;
+}
+
 /**************************************************************************/
 /*!
     @brief  Returns the current EMA value
     @returns the EMA value
 */
 /**************************************************************************/
-float EMA::value(void) { return ema_value; }
+template <typename T>
+typename BasicEMA<T>::sample_t BasicEMA<T>::value(void) { return ema_value; }
 
 /**************************************************************************/
 /*!
@@ -80,8 +134,9 @@ float EMA::value(void) { return ema_value; }
     @returns the previous EMA value
 */
 /**************************************************************************/
-float EMA::value(float new_value) {
-  float old_value = ema_value;
+template <typename T>
+typename BasicEMA<T>::sample_t BasicEMA<T>::value(sample_t new_value) {
+  sample_t old_value = ema_value;
   ema_value = new_value;
   averaging_done = true;
   return old_value;
@@ -94,7 +149,8 @@ float EMA::value(float new_value) {
              False if still averaging for initial value.
 */
 /**************************************************************************/
-bool EMA::in_ema_mode(void) { return averaging_done; }
+template <typename T>
+bool BasicEMA<T>::in_ema_mode(void) { return averaging_done; }
 
 /**************************************************************************/
 /*!
@@ -102,7 +158,8 @@ bool EMA::in_ema_mode(void) { return averaging_done; }
     @returns the number of periods used in EMA calculation
 */
 /**************************************************************************/
-U_INT EMA::getPeriods(void) { return periods; }
+template <typename T>
+U_INT BasicEMA<T>::getPeriods(void) { return periods; }
 
 /**************************************************************************/
 /*!
@@ -112,10 +169,68 @@ U_INT EMA::getPeriods(void) { return periods; }
     @returns the previous number of periods used
 */
 /**************************************************************************/
-U_INT EMA::setPeriods(U_INT n_periods) {
+template <typename T>
+U_INT BasicEMA<T>::setPeriods(U_INT n_periods) {
   U_INT old_p = periods;
   periods = n_periods;
-  k  = 2.0/(periods + 1);
-  k2 = 1.0 - k;
+  k = ema_traits<T>::coef(periods);
   return old_p;
 }
+
+/**************************************************************************/
+/*!
+    @brief  Write the EMA's state - value, periods and warm-up progress -
+            as a versioned snapshot, e.g., for EEPROM. See EMA.h for the
+            layout.
+    @param  buf
+            where to write the snapshot
+    @param  size
+            bytes available at buf
+    @returns bytes written, snapshot_size(), or 0 if it doesn't fit
+*/
+/**************************************************************************/
+template <typename T>
+size_t BasicEMA<T>::save(uint8_t* buf, size_t size) {
+  if (size < snapshot_size()) return 0;
+  uint8_t* p = ema_snapshot_header(buf, ema_traits<T>::snapshot_type, 1,
+                                   samples_to_average, averaged_samples, averaging_done);
+  p = ema_put(p, uint32_t(periods));
+  p = ema_put(p, ema_value);
+  p = warmup.save(p);
+  p = ema_put(p, ema_fletcher16(buf, p - buf));
+  return p - buf;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Resume from a snapshot written by save(), or by a one channel
+            EMABank of the same sample type
+    @param  buf
+            the snapshot
+    @param  len
+            its length
+    @returns True if restored, False if the snapshot is another version,
+             type or size, or corrupt; the EMA is then unchanged
+*/
+/**************************************************************************/
+template <typename T>
+bool BasicEMA<T>::restore(const uint8_t* buf, size_t len) {
+  if (len != snapshot_size() or not ema_snapshot_valid(buf, len, ema_traits<T>::snapshot_type, 1)) return false;
+  uint32_t to_average, averaged, n_periods;
+  const uint8_t* p = ema_get(buf + 4, to_average);
+  p = ema_get(p, averaged);
+  averaging_done = *p++;
+  p = ema_get(p, n_periods);
+  p = ema_get(p, ema_value);
+  warmup.load(p);
+  samples_to_average = (U_INT)to_average;
+  averaged_samples = (U_INT)averaged;
+  setPeriods((U_INT)n_periods);
+  return true;
+}
+
+// the sample types the library is built for
+template class BasicEMA<float>;
+template class BasicEMA<double>;
+template class BasicEMA<Q15>;
+template class BasicEMA<Q31>;
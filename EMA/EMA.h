@@ -22,6 +22,14 @@
  *
  * 	@section  HISTORY
  *
+ *  20261017  John Jordan - Added state snapshots: save(), restore().
+ *  20261017  John Jordan - Traits support StaticEMA: constexpr coef(),
+ *            shift_step().
+ *  20261017  John Jordan - Warm-up averaging keeps a running sum, optionally
+ *            compensated.
+ *  20261017  John Jordan - Added batch update().
+ *  20261017  John Jordan - Templated on sample type as BasicEMA<T>, with
+ *            Q15/Q31 fixed-point versions. EMA is BasicEMA<float>.
  *  20220516  John Jordan - Periods and samples are now unsigned ints.
  *  20220512  John Jordan - Added accessors for number of periods.
  *  20190828  John Jordan - Original.
@@ -30,25 +38,265 @@
 #ifndef EMA_H
 #define EMA_H
 
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
 #define U_INT unsigned int    // use native unsigned int
 
-class EMA {
+/*
+ * Sample types for BasicEMA<T>. float and double work as you'd expect.
+ * Q15 and Q31 are fixed-point fractions in int16_t and int32_t, the
+ * value times 2^15 or 2^31 (e.g., a raw signed 16-bit sensor reading),
+ * and update with an integer multiply and shift - no float code at all on
+ * MCUs without an FPU. Results saturate at the type's limits.
+ */
+struct Q15 {};
+struct Q31 {};
+
+/*
+ * Float warm-up averaging keeps a running sum and divides it by n: an add
+ * and a divide per sample. Build with EMA_COMPENSATED_WARMUP defined as 1
+ * (a compiler flag, since EMA.cpp is compiled on its own) to make the sum
+ * Kahan-compensated, which keeps warm-ups of thousands of samples accurate
+ * to about a float's last bit for three more adds a sample.
+ */
+#ifndef EMA_COMPENSATED_WARMUP
+#define EMA_COMPENSATED_WARMUP  0
+#endif
+
+/*
+ * State snapshots - save() writes a filter's whole state (values, periods
+ * and warm-up progress) to a byte buffer that a sketch can keep in EEPROM
+ * or flash, and restore() picks it up after a reset with no warm-up. The
+ * layout is little-endian and the same on every MCU:
+ *
+ *   [EMA_SNAPSHOT_MAGIC][EMA_SNAPSHOT_VERSION][type][channels]
+ *   [samples_to_average u32][averaged_samples u32][averaging done u8]
+ *   channels x [periods u32][ema value][warm-up sums]
+ *   [Fletcher-16 of everything before it, u16]
+ *
+ * type is the ema_traits snapshot_type: the sample type in the high
+ * nibble and its size in bytes in the low. An EMA is one channel, so an
+ * EMA snapshot restores into an EMABank<1> and back. restore() rejects
+ * a snapshot with another version, type or channel count, or a bad
+ * checksum, and leaves the filter as it was.
+ */
+#define EMA_SNAPSHOT_MAGIC    0xE5
+#define EMA_SNAPSHOT_VERSION  2
+#define EMA_SNAPSHOT_HEADER   13
+#define EMA_SNAPSHOT_TRAILER  2
+
+template <size_t B> struct ema_uint;
+template <> struct ema_uint<1> { typedef uint8_t  type; };
+template <> struct ema_uint<2> { typedef uint16_t type; };
+template <> struct ema_uint<4> { typedef uint32_t type; };
+template <> struct ema_uint<8> { typedef uint64_t type; };
+
+// store v little-endian, returns the next byte
+template <typename V>
+inline uint8_t* ema_put (uint8_t* p, V v) {
+  typename ema_uint<sizeof(V)>::type u;
+  memcpy(&u, &v, sizeof(V));
+  for (size_t i=0 ; i<sizeof(V) ; i++) p[i] = uint8_t(u >> (8 * i));
+  return p + sizeof(V);
+}
+
+template <typename V>
+inline const uint8_t* ema_get (const uint8_t* p, V& v) {
+  typename ema_uint<sizeof(V)>::type u = 0;
+  for (size_t i=0 ; i<sizeof(V) ; i++) u |= typename ema_uint<sizeof(V)>::type(p[i]) << (8 * i);
+  memcpy(&v, &u, sizeof(V));
+  return p + sizeof(V);
+}
+
+inline uint16_t ema_fletcher16 (const uint8_t* p, size_t n) {
+  uint16_t a = 0, b = 0;
+  while (n--) {
+    a = (a + *p++) % 255;
+    b = (b + a) % 255;
+  }
+  return uint16_t(b << 8 | a);
+}
+
+inline uint8_t* ema_snapshot_header (uint8_t* p, uint8_t type, uint8_t channels,
+                                     U_INT to_average, U_INT averaged, bool done) {
+  *p++ = EMA_SNAPSHOT_MAGIC;
+  *p++ = EMA_SNAPSHOT_VERSION;
+  *p++ = type;
+  *p++ = channels;
+  p = ema_put(p, uint32_t(to_average));
+  p = ema_put(p, uint32_t(averaged));
+  *p++ = done;
+  return p;
+}
+
+// checks the header and checksum of a snapshot of length len
+inline bool ema_snapshot_valid (const uint8_t* p, size_t len, uint8_t type, uint8_t channels) {
+  if (len < EMA_SNAPSHOT_HEADER + EMA_SNAPSHOT_TRAILER) return false;
+  if (p[0] != EMA_SNAPSHOT_MAGIC or p[1] != EMA_SNAPSHOT_VERSION or p[2] != type or p[3] != channels) return false;
+  uint16_t sum;
+  ema_get(p + len - EMA_SNAPSHOT_TRAILER, sum);
+  return sum == ema_fletcher16(p, len - EMA_SNAPSHOT_TRAILER);
+}
+
+// warm-up average for float types: a running sum divided by n. Both
+// versions save the sum and its compensation, so snapshots move between
+// builds with and without EMA_COMPENSATED_WARMUP.
+template <typename F, bool COMPENSATED=EMA_COMPENSATED_WARMUP>
+struct ema_float_warmup {
+  F sum;
+  static const size_t bytes = 2 * sizeof(F);
+  void clear (void) { sum = 0; }
+  uint8_t* save (uint8_t* p) const { return ema_put(ema_put(p, sum), F(0)); }
+  const uint8_t* load (const uint8_t* p) {
+    F comp;
+    p = ema_get(ema_get(p, sum), comp);
+    sum -= comp;
+    return p;
+  }
+  F add (F x, U_INT n) {
+    sum += x;
+    return sum / F(n);
+  }
+};
+
+// ... Kahan-compensated, so long warm-ups don't lose the small samples
+template <typename F>
+struct ema_float_warmup<F, true> {
+  F sum, comp;
+  static const size_t bytes = 2 * sizeof(F);
+  void clear (void) { sum = comp = 0; }
+  uint8_t* save (uint8_t* p) const { return ema_put(ema_put(p, sum), comp); }
+  const uint8_t* load (const uint8_t* p) { return ema_get(ema_get(p, sum), comp); }
+  F add (F x, U_INT n) {
+    F y = x - comp;
+    F t = sum + y;
+    comp = (t - sum) - y;
+    sum = t;
+    return sum / F(n);
+  }
+};
+
+// warm-up average for fixed-point types: an exact integer sum, rounded
+template <typename S, typename Sum>
+struct ema_int_warmup {
+  Sum sum;
+  static const size_t bytes = sizeof(Sum);
+  void clear (void) { sum = 0; }
+  uint8_t* save (uint8_t* p) const { return ema_put(p, sum); }
+  const uint8_t* load (const uint8_t* p) { return ema_get(p, sum); }
+  S add (S x, U_INT n) {
+    sum += x;
+    Sum half = Sum(n / 2);
+    return S((sum + (sum < 0 ? -half : half)) / Sum(n));
+  }
+};
+
+// the types and arithmetic behind BasicEMA<T>
+template <typename T> struct ema_traits;
+
+template <> struct ema_traits<float> {
+  typedef float sample_t;
+  typedef float coef_t;
+  typedef ema_float_warmup<float> warmup_t;
+  static const bool fixed_point = false;
+  static const uint8_t snapshot_type = 0x10 | sizeof(float);
+  static constexpr coef_t coef (U_INT periods) { return 2.0f / (periods + 1); }
+  static sample_t step (sample_t ema, sample_t x, coef_t k) { return ema + k * (x - ema); }
+};
+
+template <> struct ema_traits<double> {
+  typedef double sample_t;
+  typedef double coef_t;
+  typedef ema_float_warmup<double> warmup_t;
+  static const bool fixed_point = false;
+  static const uint8_t snapshot_type = 0x20 | sizeof(double);   // 4 bytes on AVR
+  static constexpr coef_t coef (U_INT periods) { return 2.0 / (periods + 1); }
+  static sample_t step (sample_t ema, sample_t x, coef_t k) { return ema + k * (x - ema); }
+};
+
+template <> struct ema_traits<Q15> {
+  typedef int16_t sample_t;
+  typedef int32_t coef_t;   // Q15, up to 1.0 = 32768
+  typedef ema_int_warmup<int16_t, int32_t> warmup_t;   // up to 65536 samples
+  static const bool fixed_point = true;
+  static const uint8_t snapshot_type = 0x30 | 2;
+  static constexpr coef_t coef (U_INT periods) {
+    return periods < 2 ? 32768 : int32_t((65536ul + (periods + 1) / 2) / (periods + 1));
+  }
+  // k * (x - ema) fits 32 bits: 32768 * 65535 < 2^31
+  static sample_t step (sample_t ema, sample_t x, coef_t k) {
+    int32_t delta = (k * (int32_t(x) - ema) + (1L << 14)) >> 15;
+    return saturate(ema + delta);
+  }
+  // step() for k = 2^-s, with the same rounding
+  static sample_t shift_step (sample_t ema, sample_t x, unsigned s) {
+    int32_t d = int32_t(x) - ema;
+    return saturate(ema + ((d + (s ? 1L << (s - 1) : 0)) >> s));
+  }
+  static sample_t saturate (int32_t v) {
+    return v > 32767 ? 32767 : v < -32768 ? -32768 : sample_t(v);
+  }
+  static float to_float (sample_t q) { return q * (1.0f / 32768); }
+  static sample_t from_float (float f) { return saturate(int32_t(f * 32768 + (f < 0 ? -0.5f : 0.5f))); }
+};
+
+template <> struct ema_traits<Q31> {
+  typedef int32_t sample_t;
+  typedef int64_t coef_t;   // Q31, up to 1.0 = 2^31
+  typedef ema_int_warmup<int32_t, int64_t> warmup_t;
+  static const bool fixed_point = true;
+  static const uint8_t snapshot_type = 0x40 | 4;
+  static constexpr coef_t coef (U_INT periods) {
+    return periods < 2 ? (int64_t(1) << 31) : int64_t(((uint64_t(1) << 32) + (periods + 1) / 2) / (periods + 1));
+  }
+  // k * (x - ema) fits 64 bits: 2^31 * (2^32 - 1) < 2^63
+  static sample_t step (sample_t ema, sample_t x, coef_t k) {
+    int64_t delta = (k * (int64_t(x) - ema) + (int64_t(1) << 30)) >> 31;
+    return saturate(ema + delta);
+  }
+  // step() for k = 2^-s, with the same rounding
+  static sample_t shift_step (sample_t ema, sample_t x, unsigned s) {
+    int64_t d = int64_t(x) - ema;
+    return saturate(ema + ((d + (s ? int64_t(1) << (s - 1) : 0)) >> s));
+  }
+  static sample_t saturate (int64_t v) {
+    return v > 2147483647 ? 2147483647 : v < -2147483647 - 1 ? -2147483647 - 1 : sample_t(v);
+  }
+  static float to_float (sample_t q) { return q * (1.0f / 2147483648.0f); }
+  static sample_t from_float (float f) {
+    return saturate(int64_t(double(f) * 2147483648.0 + (f < 0 ? -0.5 : 0.5)));
+  }
+};
+
+/*
+ * BasicEMA<T> - float, double, Q15 and Q31 versions are built in EMA.cpp.
+ */
+template <typename T>
+class BasicEMA {
 
  public:
 
+  typedef typename ema_traits<T>::sample_t sample_t;
+
   // c'tor - ema periods and number of samples to average to initialize ema
-  EMA (U_INT n_periods, U_INT samples_to_avg);
+  BasicEMA (U_INT n_periods, U_INT samples_to_avg);
 
   // update the ema (or average) value with a new sample
-  float update (float sample);
+  sample_t update (sample_t sample);
+
+  // update with n samples in order, e.g., a FIFO burst; writes each
+  // result to out unless it's null and returns the last
+  sample_t update (const sample_t* samples, size_t n, sample_t* out=nullptr);
 
   // get the current ema value
-  float value (void);
+  sample_t value (void);
 
   // override the current ema value or averaging results,
   // returns the old value to the caller
   // terminates averaging
-  float value (float new_value);
+  sample_t value (sample_t new_value);
 
   // test to see if still averaging samples
   bool in_ema_mode (void);
@@ -59,13 +307,33 @@ class EMA {
   // set number of periods; return old value
   U_INT setPeriods (U_INT n_periods);
 
+  // bytes needed by save()
+  static constexpr size_t snapshot_size (void) {
+    return EMA_SNAPSHOT_HEADER + 4 + sizeof(sample_t) + ema_traits<T>::warmup_t::bytes + EMA_SNAPSHOT_TRAILER;
+  }
+
+  // write the state to buf, returns the bytes written, or 0 if size is
+  // less than snapshot_size()
+  size_t save (uint8_t* buf, size_t size);
+
+  // resume from a save(); false if the snapshot doesn't fit this EMA
+  bool restore (const uint8_t* buf, size_t len);
+
  protected:
 
+  typedef typename ema_traits<T>::coef_t coef_t;
+
   U_INT  samples_to_average;   // samples to average
   U_INT  averaged_samples = 0; // how many so far
   bool averaging_done = false;  // done with averaging by count or override
-  float k, k2, ema_value;       // constants and our progressive ema value
-  U_INT  periods;              // number of periods EMA is calculated over
-}; // class EMA
+  coef_t k;                     // smoothing constant, 2/(periods+1)
+  typename ema_traits<T>::warmup_t warmup;  // running sum while averaging
+  sample_t ema_value = 0;       // our progressive ema value
+  U_INT  periods = 0;          // number of periods EMA is calculated over
+}; // class BasicEMA
+
+typedef BasicEMA<float> EMA;
+typedef BasicEMA<Q15>   EMA_Q15;
+typedef BasicEMA<Q31>   EMA_Q31;
 
 #endif /* _H */
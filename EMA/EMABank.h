@@ -0,0 +1,168 @@
+/*!
+ *  @file EMABank.h
+ *
+ *  @section intro_sec Introduction
+ *
+ *  N float EMAs updated together, e.g., one per IMU axis. The channel
+ *  states are kept in contiguous arrays (structure of arrays) so one
+ *  update() call runs a single loop over all channels, which compilers
+ *  vectorize; SSE and NEON builds use intrinsics directly. Each channel
+ *  has its own periods; warm-up averaging is shared, since all channels
+ *  get a sample on every update.
+ *
+ *  @section usage Usage
+ *
+ *  EMABank<9> imu_ema(15, 4);   // 9 channels, 15 periods, average 4 samples
+ *  imu_ema.setPeriods(8, 50);   // slower on the last channel
+ *  const float* smooth = imu_ema.update(raw);   // raw is float[9]
+ *
+ * 	@section  HISTORY
+ *
+ *  20261017  John Jordan - Added state snapshots: save(), restore().
+ *  20261017  John Jordan - Original.
+ */
+
+#ifndef EMA_BANK_H
+#define EMA_BANK_H
+
+#include <stddef.h>
+#include "EMA.h"
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#define EMA_BANK_SIMD  4
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define EMA_BANK_SIMD  4
+#endif
+
+template <size_t N>
+class EMABank {
+
+  static_assert(N > 0 and N < 256, "EMABank has 1 to 255 channels");
+
+ public:
+
+  // c'tor - ema periods for every channel and number of samples to average
+  EMABank (U_INT n_periods, U_INT samples_to_avg) : samples_to_average(samples_to_avg) {
+    for (size_t i=0 ; i<N ; i++) {
+      ema_value[i] = 0;
+      warmup[i].clear();
+      periods[i] = 0;
+    }
+    setPeriods(n_periods);
+  }
+
+  // update every channel with samples[0..N-1], returns the N ema values
+  const float* update (const float* samples) {
+    if (averaging_done) {
+      _step(samples);
+    } else {
+      ++averaged_samples;
+      for (size_t i=0 ; i<N ; i++) ema_value[i] = warmup[i].add(samples[i], averaged_samples);
+      averaging_done = (averaged_samples >= samples_to_average);
+    }
+    return ema_value;
+  }
+
+  // the current ema values
+  const float* values (void) const { return ema_value; }
+  float value (size_t channel) const { return channel < N ? ema_value[channel] : 0.0f; }
+
+  // override all ema values, terminates averaging
+  void values (const float* new_values) {
+    for (size_t i=0 ; i<N ; i++) ema_value[i] = new_values[i];
+    averaging_done = true;
+  }
+
+  // test to see if still averaging samples
+  bool in_ema_mode (void) const { return averaging_done; }
+
+  // periods of one channel, 0 if there's no such channel
+  U_INT getPeriods (size_t channel) const { return channel < N ? periods[channel] : 0; }
+
+  // set periods of every channel, or one; returns the old value, or 0 and
+  // changes nothing if there's no such channel
+  void setPeriods (U_INT n_periods) {
+    for (size_t i=0 ; i<N ; i++) setPeriods(i, n_periods);
+  }
+
+  U_INT setPeriods (size_t channel, U_INT n_periods) {
+    if (channel >= N) return 0;
+    U_INT old_p = periods[channel];
+    periods[channel] = n_periods;
+    k[channel] = ema_traits<float>::coef(n_periods);
+    return old_p;
+  }
+
+  static size_t channels (void) { return N; }
+
+  // bytes needed by save()
+  static constexpr size_t snapshot_size (void) {
+    return EMA_SNAPSHOT_HEADER + N * (4 + sizeof(float) + ema_float_warmup<float>::bytes) + EMA_SNAPSHOT_TRAILER;
+  }
+
+  // write every channel's state to buf in EMA's snapshot layout, returns
+  // the bytes written, or 0 if size is less than snapshot_size()
+  size_t save (uint8_t* buf, size_t size) const {
+    if (size < snapshot_size()) return 0;
+    uint8_t* p = ema_snapshot_header(buf, ema_traits<float>::snapshot_type, N,
+                                     samples_to_average, averaged_samples, averaging_done);
+    for (size_t i=0 ; i<N ; i++) {
+      p = ema_put(p, uint32_t(periods[i]));
+      p = ema_put(p, ema_value[i]);
+      p = warmup[i].save(p);
+    }
+    p = ema_put(p, ema_fletcher16(buf, p - buf));
+    return p - buf;
+  }
+
+  // resume from a save(); false if the snapshot doesn't fit this bank
+  bool restore (const uint8_t* buf, size_t len) {
+    if (len != snapshot_size() or not ema_snapshot_valid(buf, len, ema_traits<float>::snapshot_type, N)) return false;
+    uint32_t to_average, averaged, n_periods;
+    const uint8_t* p = ema_get(buf + 4, to_average);
+    p = ema_get(p, averaged);
+    averaging_done = *p++;
+    for (size_t i=0 ; i<N ; i++) {
+      p = ema_get(p, n_periods);
+      p = ema_get(p, ema_value[i]);
+      p = warmup[i].load(p);
+      setPeriods(i, (U_INT)n_periods);
+    }
+    samples_to_average = (U_INT)to_average;
+    averaged_samples = (U_INT)averaged;
+    return true;
+  }
+
+ protected:
+
+  // ema + k(sample - ema) for every channel, same arithmetic as EMA
+  void _step (const float* samples) {
+    size_t i = 0;
+#if defined(EMA_BANK_SIMD) && defined(__SSE__)
+    for ( ; i + 4 <= N ; i += 4) {
+      __m128 v = _mm_load_ps(ema_value + i);
+      __m128 d = _mm_sub_ps(_mm_loadu_ps(samples + i), v);
+      _mm_store_ps(ema_value + i, _mm_add_ps(v, _mm_mul_ps(_mm_load_ps(k + i), d)));
+    }
+#elif defined(EMA_BANK_SIMD) && defined(__ARM_NEON)
+    for ( ; i + 4 <= N ; i += 4) {
+      float32x4_t v = vld1q_f32(ema_value + i);
+      float32x4_t d = vsubq_f32(vld1q_f32(samples + i), v);
+      vst1q_f32(ema_value + i, vaddq_f32(v, vmulq_f32(vld1q_f32(k + i), d)));
+    }
+#endif
+    for ( ; i<N ; i++) ema_value[i] += k[i] * (samples[i] - ema_value[i]);
+  }
+
+  alignas(16) float ema_value[N];   // our progressive ema values
+  alignas(16) float k[N];           // smoothing constants, 2/(periods+1)
+  ema_float_warmup<float> warmup[N];  // running sums while averaging, as EMA's
+  U_INT  periods[N];
+  U_INT  samples_to_average;        // samples to average
+  U_INT  averaged_samples = 0;      // how many so far
+  bool averaging_done = false;      // done with averaging by count or override
+}; // class EMABank
+
+#endif /* _H */
@@ -0,0 +1,111 @@
+/*!
+ *  @file EMAChain.h
+ *
+ *  @section intro_sec Introduction
+ *
+ *  The usual EMA combinations in one filter: a fast and a slow EMA, their
+ *  difference and a signal line EMA of the difference (MACD style), and
+ *  the double and triple smoothed DEMA and TEMA of the fast EMA. All the
+ *  stage states are kept together and updated in one call with one
+ *  warm-up, instead of a chain of EMA objects each with its own.
+ *
+ *  @section usage Usage
+ *
+ *  EMAChain trend(15, 100, 9, 4);   // fast, slow, signal periods, average 4
+ *  trend.update(sample);
+ *  if (trend.histogram() > 0) ...   // difference above its signal line
+ *
+ * 	@section  HISTORY
+ *
+ *  20261017  John Jordan - Original.
+ */
+
+#ifndef EMA_CHAIN_H
+#define EMA_CHAIN_H
+
+#include "EMA.h"
+
+// everything EMAChain::update() produces
+struct ema_chain_t {
+  float fast;      // EMA(fast periods)
+  float slow;      // EMA(slow periods)
+  float diff;      // fast - slow
+  float signal;    // EMA(signal periods) of diff
+  float dema;      // 2 EMA - EMA(EMA), fast periods
+  float tema;      // 3 EMA - 3 EMA(EMA) + EMA(EMA(EMA)), fast periods
+};
+
+class EMAChain {
+
+ public:
+
+  // c'tor - fast, slow and signal line periods, and number of samples to
+  // average to initialize every stage
+  EMAChain (U_INT fast_periods, U_INT slow_periods, U_INT signal_periods, U_INT samples_to_avg)
+    : samples_to_average(samples_to_avg) {
+    warmup.clear();
+    setPeriods(fast_periods, slow_periods, signal_periods);
+    value(0);
+    averaging_done = false;
+  }
+
+  // update every stage with a new sample
+  const ema_chain_t& update (float sample) {
+    if (averaging_done) {
+      e1 += k_fast * (sample - e1);
+      e2 += k_fast * (e1 - e2);
+      e3 += k_fast * (e2 - e3);
+      out.slow += k_slow * (sample - out.slow);
+      float diff = e1 - out.slow;
+      out.signal += k_signal * (diff - out.signal);
+      out.diff = diff;
+    } else {
+      // every stage of a constant input is that constant: start them all
+      // at the average, with no difference
+      e1 = e2 = e3 = out.slow = warmup.add(sample, ++averaged_samples);
+      averaging_done = (averaged_samples >= samples_to_average);
+    }
+    out.fast = e1;
+    out.dema = 2 * e1 - e2;
+    out.tema = 3 * (e1 - e2) + e3;
+    return out;
+  }
+
+  // the outputs of the last update
+  const ema_chain_t& values (void) const { return out; }
+  float fast (void) const { return out.fast; }
+  float slow (void) const { return out.slow; }
+  float difference (void) const { return out.diff; }
+  float signal (void) const { return out.signal; }
+  float histogram (void) const { return out.diff - out.signal; }
+  float dema (void) const { return out.dema; }
+  float tema (void) const { return out.tema; }
+
+  // set every stage to new_value, with no difference, terminates averaging
+  void value (float new_value) {
+    e1 = e2 = e3 = out.fast = out.slow = out.dema = out.tema = new_value;
+    out.diff = out.signal = 0;
+    averaging_done = true;
+  }
+
+  // test to see if still averaging samples
+  bool in_ema_mode (void) const { return averaging_done; }
+
+  void setPeriods (U_INT fast_periods, U_INT slow_periods, U_INT signal_periods) {
+    k_fast   = ema_traits<float>::coef(fast_periods);
+    k_slow   = ema_traits<float>::coef(slow_periods);
+    k_signal = ema_traits<float>::coef(signal_periods);
+  }
+
+ protected:
+
+  ema_chain_t out;
+  float  e1, e2, e3;            // fast EMA, and it smoothed once and twice more
+  float  k_fast, k_slow, k_signal;
+  ema_float_warmup<float> warmup;  // running sum while averaging
+  U_INT  samples_to_average;    // samples to average
+  U_INT  averaged_samples = 0;  // how many so far
+  bool averaging_done = false;  // done with averaging by count or override
+}; // class EMAChain
+
+#endif /* _H */
@@ -0,0 +1,112 @@
+/*!
+ *  @file EMVar.h
+ *
+ *  @section intro_sec Introduction
+ *
+ *  An EMA with an exponentially weighted variance, for a noise estimate
+ *  alongside the smoothed value, e.g., touch thresholds or vibration
+ *  alarms. Mean and variance are updated together in one step: Welford's
+ *  method while averaging the first samples, then the exponentially
+ *  weighted recurrence
+ *
+ *    d = x - mean,  mean += k d,  var = (1 - k)(var + k d^2)
+ *
+ *  The mean is exactly EMA's. The standard deviation is only computed when
+ *  asked for, and only once per new sample.
+ *
+ *  @section usage Usage
+ *
+ *  EMVar z_stats(30, 8);            // 30 periods, average 8 samples
+ *  z_stats.update(z);
+ *  if (z > z_stats.mean() + 4 * z_stats.stddev()) ...   // touch
+ *
+ * 	@section  HISTORY
+ *
+ *  20261017  John Jordan - Original.
+ */
+
+#ifndef EM_VAR_H
+#define EM_VAR_H
+
+#include <math.h>
+#include "EMA.h"
+
+class EMVar {
+
+ public:
+
+  // c'tor - ema periods and number of samples to average to initialize
+  EMVar (U_INT n_periods, U_INT samples_to_avg) : samples_to_average(samples_to_avg) {
+    warmup.clear();
+    setPeriods(n_periods);
+  }
+
+  // update mean and variance with a new sample, returns the mean
+  float update (float sample) {
+    float d = sample - ema_value;
+    if (averaging_done) {
+      float incr = k * d;
+      ema_value += incr;
+      var = (1 - k) * (var + d * incr);
+    } else {
+      // Welford: m2 += (x - old mean)(x - new mean)
+      ema_value = warmup.add(sample, ++averaged_samples);
+      m2 += d * (sample - ema_value);
+      var = m2 / averaged_samples;
+      averaging_done = (averaged_samples >= samples_to_average);
+    }
+    sd_valid = false;
+    return ema_value;
+  }
+
+  // the current mean, the same value as an EMA's
+  float mean (void) const { return ema_value; }
+  float value (void) const { return ema_value; }
+
+  // override the mean, terminates averaging; returns the old mean
+  float value (float new_value) {
+    float old_value = ema_value;
+    ema_value = new_value;
+    averaging_done = true;
+    return old_value;
+  }
+
+  float variance (void) const { return var; }
+
+  // sqrt(variance), computed on the first call after an update
+  float stddev (void) {
+    if (not sd_valid) {
+      sd = sqrtf(var);
+      sd_valid = true;
+    }
+    return sd;
+  }
+
+  // test to see if still averaging samples
+  bool in_ema_mode (void) const { return averaging_done; }
+
+  U_INT getPeriods (void) const { return periods; }
+
+  U_INT setPeriods (U_INT n_periods) {
+    U_INT old_p = periods;
+    periods = n_periods;
+    k = ema_traits<float>::coef(n_periods);
+    return old_p;
+  }
+
+ protected:
+
+  float  ema_value = 0;         // the mean
+  float  var = 0;               // the variance
+  float  m2 = 0;                // sum of squared deviations while averaging
+  float  sd = 0;                // sqrt(var), when sd_valid
+  float  k;                     // smoothing constant, 2/(periods+1)
+  ema_float_warmup<float> warmup;  // running sum while averaging
+  U_INT  periods = 0;
+  U_INT  samples_to_average;    // samples to average
+  U_INT  averaged_samples = 0;  // how many so far
+  bool averaging_done = false;  // done with averaging by count or override
+  bool sd_valid = true;
+}; // class EMVar
+
+#endif /* _H */
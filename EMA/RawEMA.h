@@ -0,0 +1,132 @@
+/*!
+ *  @file RawEMA.h
+ *
+ *  @section intro_sec Introduction
+ *
+ *  An EMA that smooths raw sensor counts - int16_t from an IMU, uint16_t
+ *  from Cirque X/Y - without converting each sample to float. The state is
+ *  a 32-bit accumulator holding the EMA in counts with 15 fractional bits,
+ *  so small steps don't stall as they would on an int16_t EMA, and each
+ *  update is an integer subtract, multiply and shift. Convert once, when
+ *  the value is read: value() gives rounded counts and scaled() gives
+ *  counts times a factor, e.g., 1/16384 g per count.
+ *
+ *  @section usage Usage
+ *
+ *  RawEMA ax_ema(15, 4, 1.0f / 16384);   // 15 periods, average 4, in g
+ *  ax_ema.update(raw_ax);                // int16_t counts
+ *  float ax = ax_ema.scaled();
+ *
+ *  RawEMA_U16 x_ema(8, 2);               // Cirque xValue
+ *  uint16_t x = x_ema.update(data.xValue);
+ *
+ * 	@section  HISTORY
+ *
+ *  20261017  John Jordan - Original.
+ */
+
+#ifndef RAW_EMA_H
+#define RAW_EMA_H
+
+#include <stdint.h>
+#include "EMA.h"
+
+#define RAW_EMA_FRAC_BITS  15
+#define RAW_EMA_ONE        (1L << RAW_EMA_FRAC_BITS)  // one count in acc
+
+// offset to the signed range: uint16_t counts are filtered as x - 32768
+template <typename S> struct raw_ema_offset;
+template <> struct raw_ema_offset<int16_t>  { static const int32_t value = 0; };
+template <> struct raw_ema_offset<uint16_t> { static const int32_t value = 32768; };
+
+template <typename S>
+class BasicRawEMA {
+
+ public:
+
+  typedef S sample_t;
+
+  // c'tor - ema periods, number of samples to average to initialize ema,
+  // and the units per count for scaled()
+  BasicRawEMA (U_INT n_periods, U_INT samples_to_avg, float scale=1.0f)
+    : samples_to_average(samples_to_avg) {
+    setPeriods(n_periods);
+    setScale(scale);
+  }
+
+  // update the ema (or average) with a new sample, returns it in counts
+  sample_t update (sample_t sample) {
+    // multiply, not <<, which is undefined for negative counts
+    int32_t x = (int32_t(sample) - OFFSET) * RAW_EMA_ONE;
+    if (averaging_done) {
+      // |x - acc| < 2^31 and k <= 2^16, so the product fits 48 bits
+      acc += int32_t((int64_t(k) * (x - acc) + 0x8000) >> 16);
+    } else {
+      sum += int32_t(sample) - OFFSET;
+      int64_t n = ++averaged_samples;
+      int64_t s = int64_t(sum) * RAW_EMA_ONE;
+      acc = int32_t((s + (s < 0 ? -n : n) / 2) / n);
+      averaging_done = (averaged_samples >= samples_to_average);
+    }
+    return value();
+  }
+
+  // the current ema, rounded to counts
+  sample_t value (void) const {
+    return sample_t(((acc + RAW_EMA_ONE / 2) >> RAW_EMA_FRAC_BITS) + OFFSET);
+  }
+
+  // override the current ema value or averaging results, terminates
+  // averaging; returns the old value
+  sample_t value (sample_t new_value) {
+    sample_t old_value = value();
+    acc = (int32_t(new_value) - OFFSET) * RAW_EMA_ONE;
+    averaging_done = true;
+    return old_value;
+  }
+
+  // the current ema with its fraction, times the scale factor
+  float scaled (void) const { return float(acc) * frac_scale + offset_scaled; }
+
+  // the accumulator: (counts - offset) * 2^RAW_EMA_FRAC_BITS
+  int32_t accumulator (void) const { return acc; }
+
+  float getScale (void) const { return scale; }
+
+  void setScale (float units_per_count) {
+    scale = units_per_count;
+    frac_scale = units_per_count / RAW_EMA_ONE;
+    offset_scaled = OFFSET * units_per_count;
+  }
+
+  // test to see if still averaging samples
+  bool in_ema_mode (void) const { return averaging_done; }
+
+  U_INT getPeriods (void) const { return periods; }
+
+  // set number of periods; return old value
+  U_INT setPeriods (U_INT n_periods) {
+    U_INT old_p = periods;
+    periods = n_periods;
+    k = n_periods < 2 ? 65536 : int32_t((131072ul + (n_periods + 1) / 2) / (n_periods + 1));   // Q16
+    return old_p;
+  }
+
+ protected:
+
+  static const int32_t OFFSET = raw_ema_offset<S>::value;
+
+  int32_t acc = 0;              // the ema, in counts with fractional bits
+  int32_t sum = 0;              // sum of counts while averaging
+  int32_t k;                    // smoothing constant, 2/(periods+1), Q16
+  float  scale, frac_scale, offset_scaled;
+  U_INT  periods = 0;
+  U_INT  samples_to_average;    // samples to average
+  U_INT  averaged_samples = 0;  // how many so far
+  bool averaging_done = false;  // done with averaging by count or override
+}; // class BasicRawEMA
+
+typedef BasicRawEMA<int16_t>  RawEMA;
+typedef BasicRawEMA<uint16_t> RawEMA_U16;
+
+#endif /* _H */
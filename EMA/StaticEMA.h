@@ -0,0 +1,96 @@
+/*!
+ *  @file StaticEMA.h
+ *
+ *  @section intro_sec Introduction
+ *
+ *  An EMA whose periods and warm-up length are template arguments. The
+ *  smoothing constant is a constexpr the compiler folds into update(), so
+ *  the object holds only its state - no k, no periods. For the fixed-point
+ *  types, periods of the form 2^n - 1 (1, 3, 7, 15, 31, ...) make k a power
+ *  of two and update() a subtract, shift and add, with the same results as
+ *  the multiply.
+ *
+ *  @section usage Usage
+ *
+ *  StaticEMA<15, 4> ax_ema;          // float, 15 periods, average 4 samples
+ *  StaticEMA<31, 8, Q15> z_ema;      // Q15, k = 1/16: shifts only
+ *  float smooth = ax_ema.update(ax);
+ *
+ * 	@section  HISTORY
+ *
+ *  20261017  John Jordan - Original.
+ */
+
+#ifndef STATIC_EMA_H
+#define STATIC_EMA_H
+
+#include "EMA.h"
+
+// s when periods + 1 == 2^(s+1), i.e., k == 2^-s; otherwise -1
+constexpr int ema_pow2_shift (U_INT periods, int s=-1) {
+  return periods == 0 ? -1
+       : periods == 1 ? s + 1
+       : (periods & 1) ? ema_pow2_shift(periods >> 1, s + 1) : -1;
+}
+
+template <bool B> struct ema_bool {};
+
+template <U_INT Periods, U_INT WarmupSamples, typename T=float>
+class StaticEMA {
+
+ public:
+
+  typedef typename ema_traits<T>::sample_t sample_t;
+  typedef typename ema_traits<T>::coef_t   coef_t;
+
+  static constexpr coef_t k = ema_traits<T>::coef(Periods);
+  static constexpr int    shift = ema_pow2_shift(Periods);
+  static const bool       shifts = ema_traits<T>::fixed_point and shift >= 0;
+
+  StaticEMA (void) { warmup.clear(); }
+
+  // update the ema (or average) value with a new sample
+  sample_t update (sample_t sample) {
+    if (averaging_done) {
+      ema_value = _step(sample, ema_bool<shifts>());
+    } else {
+      ema_value = warmup.add(sample, ++averaged_samples);
+      averaging_done = (averaged_samples >= WarmupSamples);
+    }
+    return ema_value;
+  }
+
+  // get the current ema value
+  sample_t value (void) const { return ema_value; }
+
+  // override the current ema value or averaging results, terminates
+  // averaging; returns the old value
+  sample_t value (sample_t new_value) {
+    sample_t old_value = ema_value;
+    ema_value = new_value;
+    averaging_done = true;
+    return old_value;
+  }
+
+  // test to see if still averaging samples
+  bool in_ema_mode (void) const { return averaging_done; }
+
+  static constexpr U_INT getPeriods (void) { return Periods; }
+
+ protected:
+
+  sample_t _step (sample_t x, ema_bool<true>) {
+    return ema_traits<T>::shift_step(ema_value, x, shift);
+  }
+
+  sample_t _step (sample_t x, ema_bool<false>) {
+    return ema_traits<T>::step(ema_value, x, k);
+  }
+
+  sample_t ema_value = 0;       // our progressive ema value
+  typename ema_traits<T>::warmup_t warmup;  // running sum while averaging
+  U_INT  averaged_samples = 0;  // how many so far
+  bool averaging_done = false;  // done with averaging by count or override
+}; // class StaticEMA
+
+#endif /* _H */
@@ -0,0 +1,143 @@
+/*!
+ *  @file TimedEMA.h
+ *
+ *  @section intro_sec Introduction
+ *
+ *  An EMA for samples that arrive at irregular intervals, e.g., from a
+ *  data-ready interrupt. Each update() is given the time since the last
+ *  sample and weights it by alpha = 1 - exp(-dt/tau), so a late or missed
+ *  sample moves the average as far as the elapsed time warrants, and at
+ *  the nominal interval alpha equals EMA's 2/(periods+1). exp() is a fast
+ *  approximation good to float precision, and the last alpha is cached,
+ *  so a steady interval costs about the same as EMA::update().
+ *
+ *  @section usage Usage
+ *
+ *  TimedEMA z_ema(15, 10000, 4);   // 15 periods of 10 ms, average 4 samples
+ *  float z = z_ema.update(sample, dt_us);
+ *  float z = z_ema.update_at(sample, micros());   // or from timestamps
+ *
+ * 	@section  HISTORY
+ *
+ *  20261017  John Jordan - update_at() times its first sample at the nominal
+ *            interval, so a value() seed isn't replaced.
+ *  20261017  John Jordan - Original.
+ */
+
+#ifndef TIMED_EMA_H
+#define TIMED_EMA_H
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include "EMA.h"
+
+/*
+ * 1 - exp(-x) for x >= 0, without expf(). Small x use the series, which
+ * keeps full relative precision when dt is much shorter than tau. Larger x
+ * split e^-x into 2^-(j/16), a shift of the float exponent and a table
+ * entry, times e^-g for the remainder g < ln2/16, a quartic. Past x = 17
+ * the result rounds to 1.
+ */
+inline float ema_alpha (float x) {
+  static const float pow2_16th[16] = {   // 2^-(j/16)
+    1.0f, 0.957603281f, 0.917004043f, 0.87812608f, 0.840896415f, 0.805245166f, 0.771105413f, 0.738413073f,
+    0.707106781f, 0.677127773f, 0.648419777f, 0.620928906f, 0.594603558f, 0.569394317f, 0.545253866f, 0.522136891f };
+  if (not (x > 0)) return 0;
+  if (x < 0.0625f) return x * (1 - x * (0.5f - x * (1.0f / 6 - x * (1.0f / 24))));
+  if (x > 17.0f) return 1;
+  float y = x * 23.0831206f;            // 16 / ln 2
+  int j = int(y);
+  float g = (y - j) * 0.0433216988f;    // ln 2 / 16
+  float e = 1 - g * (1 - g * (0.5f - g * (1.0f / 6 - g * (1.0f / 24))));
+  uint32_t bits = uint32_t(127 - (j >> 4)) << 23;   // 2^-(j/16), whole part
+  float scale;
+  memcpy(&scale, &bits, 4);
+  return 1 - e * pow2_16th[j & 15] * scale;
+}
+
+class TimedEMA {
+
+ public:
+
+  // c'tor - ema periods at a nominal sample interval, and number of samples
+  // to average to initialize ema
+  TimedEMA (U_INT n_periods, uint32_t sample_us, U_INT samples_to_avg)
+    : samples_to_average(samples_to_avg) {
+    warmup.clear();
+    setPeriods(n_periods, sample_us);
+  }
+
+  // update the ema (or average) with a sample taken dt_us after the last
+  float update (float sample, uint32_t dt_us) {
+    if (averaging_done) {
+      if (dt_us != last_dt) {
+        last_dt = dt_us;
+        alpha = ema_alpha(float(dt_us) * inv_tau);
+      }
+      ema_value += alpha * (sample - ema_value);
+    } else {
+      ema_value = warmup.add(sample, ++averaged_samples);
+      averaging_done = (averaged_samples >= samples_to_average);
+    }
+    return ema_value;
+  }
+
+  // update with a sample taken at now_us, e.g., micros(); handles the wrap.
+  // The first call, and the first after value(new), has no previous time
+  // and counts as the nominal interval.
+  float update_at (float sample, uint32_t now_us) {
+    uint32_t dt_us = have_time ? now_us - last_us : nominal_us;
+    last_us = now_us;
+    have_time = true;
+    return update(sample, dt_us);
+  }
+
+  // get the current ema value
+  float value (void) const { return ema_value; }
+
+  // override the current ema value or averaging results, terminates
+  // averaging; returns the old value
+  float value (float new_value) {
+    float old_value = ema_value;
+    ema_value = new_value;
+    averaging_done = true;
+    have_time = false;
+    return old_value;
+  }
+
+  // test to see if still averaging samples
+  bool in_ema_mode (void) const { return averaging_done; }
+
+  // time constant tau, in microseconds
+  float getTau (void) const { return 1 / inv_tau; }
+
+  void setTau (float tau_us) {
+    inv_tau = 1 / tau_us;
+    last_dt = 0;
+    alpha = 0;
+  }
+
+  // tau giving alpha = 2/(periods+1) at sample_us
+  void setPeriods (U_INT n_periods, uint32_t sample_us) {
+    float k = ema_traits<float>::coef(n_periods);
+    nominal_us = sample_us;
+    setTau(k < 1 ? -float(sample_us) / logf(1 - k) : 0);
+  }
+
+ protected:
+
+  float  ema_value = 0;         // our progressive ema value
+  float  inv_tau;               // 1/tau, per microsecond
+  float  alpha = 0;             // weight for a sample last_dt after the last
+  uint32_t last_dt = 0;
+  uint32_t last_us = 0;         // for update_at()
+  uint32_t nominal_us = 0;      // sample interval given to setPeriods()
+  bool have_time = false;       // last_us is a real sample time
+  ema_float_warmup<float> warmup;  // running sum while averaging
+  U_INT  samples_to_average;    // samples to average
+  U_INT  averaged_samples = 0;  // how many so far
+  bool averaging_done = false;  // done with averaging by count or override
+}; // class TimedEMA
+
+#endif /* _H */
@@ -2,14 +2,16 @@
  * Plot EMA values demo.
  *
  * 2022-05-16  John Jordan
+ * 2026-10-17  Fast and slow EMAs from one EMAChain, plus their difference.
  ****************************************************************************/
 
 #include <EMA.h>
+#include <EMAChain.h>
 
 #define DONT_CARE 5
 
-EMA slow_ema(100, DONT_CARE); // samples_to_average don't matter - we set init value later
-EMA fast_ema(15,  DONT_CARE);
+// fast, slow and signal line periods; samples_to_average doesn't matter - we set init value later
+EMAChain trend(15, 100, 9, DONT_CARE);
 EMA avg(DONT_CARE, 400);      // create an averaging function - ema_periods don't matter,
                               // we're averaging the entire time (361 plot points)
 
@@ -19,19 +21,17 @@ void setup (void) {
 
   // for this plotting example, don't init EMAs
   // by averaging, just set to 0
-  slow_ema.value(0);
-  fast_ema.value(0);
+  trend.value(0);
 }
 
 // plot two sine wave cycles, scaled to a +/-5 chart
 
 void loop (void) {
-  float slow, fast, average, y;
+  float average, y;
   for (int i=0 ; i<=720 ; i+=2) {
     y = sin(PI*i/180.0); // convert arg to radians
     // calcutate exponential and simple moving averages
-    slow = slow_ema.update(y);
-    fast = fast_ema.update(y);
+    const ema_chain_t& ema = trend.update(y);
     average = avg.update(y);
     // plot values, place values in plot legend, scale graph
     Serial.print("y=");
@@ -40,20 +40,29 @@ void loop (void) {
     Serial.print(4.0*y);
 
     Serial.print(",slow=");
-    Serial.print(slow);
+    Serial.print(ema.slow);
     Serial.print(":");
-    Serial.print(4.0*slow);
+    Serial.print(4.0*ema.slow);
 
     Serial.print(",fast=");
-    Serial.print(fast);
+    Serial.print(ema.fast);
     Serial.print(":");
-    Serial.print(4.0*fast);
+    Serial.print(4.0*ema.fast);
+
+    Serial.print(",diff=");
+    Serial.print(ema.diff);
+    Serial.print(":");
+    Serial.print(4.0*ema.diff);
 
     Serial.print(",avg=");
     Serial.print(average);
     Serial.print(":");
     Serial.print(4.0*average);
     Serial.println();
+    // delay() stays: it is the time base of this synthetic sine, so every
+    // one of the 361 points is plotted at a steady pace. Plot's throttle()
+    // is for real-time sensors - it would drop points here (see the
+    // CirquePinnacle cirque_plot example).
     delay(25);
   }
   while (1) delay(10); // wait for upload with new EMA periods :-)
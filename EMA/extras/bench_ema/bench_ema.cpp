@@ -0,0 +1,276 @@
+/****************************************************************************
+ * Host micro-benchmark: cycles per EMA update for each sample type.
+ *
+ * Runs BasicEMA<float>, <double>, <Q15> and <Q31> over the same noisy sine
+ * wave and reports cycles (TSC ticks on x86, else nanoseconds) per update,
+ * and the worst error against a double reference once past warm-up.
+ * Then compares 9 separate EMA objects with one EMABank<9>, as for an IMU,
+ * and per-sample update() calls with one batch update() over a buffer.
+ * Last, a long warm-up: the old recover-the-sum-and-divide average
+ * against the running sum EMA keeps now, which saves the multiply, and
+ * the Kahan-compensated sum built with EMA_COMPENSATED_WARMUP, which
+ * costs three more adds and is accurate to about a float's last bit.
+ * And TimedEMA at a steady interval (cached alpha), with jittered
+ * intervals, and with the same jitter using expf(). Last, raw int16
+ * counts: converted to float for each sample and smoothed with EMA, or
+ * smoothed with RawEMA and converted once.
+ *
+ * Build and run on Linux:
+ *   g++ -O2 -I../.. bench_ema.cpp ../../EMA.cpp -o bench_ema && ./bench_ema
+ *
+ * Host numbers only show the relative cost. On an FPU-less Cortex-M0+
+ * each float update is a software multiply and two adds, so the Q15 and
+ * Q31 versions pull much further ahead than they do here.
+ ****************************************************************************/
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+#include "EMA.h"
+#include "EMABank.h"
+#include "TimedEMA.h"
+#include "RawEMA.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+static inline unsigned long long ticks(void) { return __rdtsc(); }
+static const char* tick_unit = "cycles";
+#else
+static inline unsigned long long ticks(void) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+static const char* tick_unit = "ns";
+#endif
+
+static const int    SAMPLES = 1 << 16;
+static const int    ROUNDS  = 200;
+static const U_INT  PERIODS = 15;
+
+static std::vector<double> input(void) {
+  std::vector<double> x(SAMPLES);
+  unsigned seed = 1;
+  for (int i=0 ; i<SAMPLES ; i++) {
+    seed = seed * 1103515245u + 12345u;
+    double noise = ((seed >> 16) & 0x7FFF) / 32768.0 - 0.5;
+    x[i] = 0.6 * sin(i * 0.01) + 0.2 * noise;   // stays inside Q15's [-1, 1)
+  }
+  return x;
+}
+
+template <typename T, typename S>
+static void bench(const char* name, const std::vector<S>& x,
+                  const std::vector<double>& ref, double (*to_double)(S)) {
+  BasicEMA<T> ema(PERIODS, PERIODS);
+  volatile S sink = 0;
+  unsigned long long best = ~0ull;
+  for (int r=0 ; r<ROUNDS ; r++) {
+    unsigned long long t0 = ticks();
+    S acc = 0;
+    for (int i=0 ; i<SAMPLES ; i++) acc = ema.update(x[i]);
+    unsigned long long t = ticks() - t0;
+    sink = acc;
+    if (t < best) best = t;
+  }
+  (void)sink;
+
+  BasicEMA<T> check(PERIODS, PERIODS);
+  double worst = 0;
+  for (int i=0 ; i<SAMPLES ; i++) {
+    double e = fabs(to_double(check.update(x[i])) - ref[i]);
+    if (i >= int(PERIODS) and e > worst) worst = e;
+  }
+  printf("%-8s %6.2f %s/update   max error %.2e\n", name, double(best) / SAMPLES, tick_unit, worst);
+}
+
+static double from_f(float v)    { return v; }
+static double from_d(double v)   { return v; }
+static double from_q15(int16_t v) { return v / 32768.0; }
+static double from_q31(int32_t v) { return v / 2147483648.0; }
+
+// 9 axes as separate EMA objects vs. one EMABank<9>, cycles per frame
+static void bench_bank(const std::vector<float>& xf) {
+  const int CH = 9;
+  const int FRAMES = SAMPLES / CH;
+  EMA* single[CH];
+  for (int c=0 ; c<CH ; c++) single[c] = new EMA(PERIODS + c, PERIODS);
+  EMABank<CH> bank(PERIODS, PERIODS);
+  for (int c=0 ; c<CH ; c++) bank.setPeriods(c, PERIODS + c);
+
+  unsigned long long best_single = ~0ull, best_bank = ~0ull;
+  volatile float sink = 0;
+  for (int r=0 ; r<ROUNDS ; r++) {
+    unsigned long long t0 = ticks();
+    for (int f=0 ; f<FRAMES ; f++) {
+      const float* x = &xf[f * CH];
+      for (int c=0 ; c<CH ; c++) single[c]->update(x[c]);
+    }
+    unsigned long long t1 = ticks();
+    for (int f=0 ; f<FRAMES ; f++) bank.update(&xf[f * CH]);
+    unsigned long long t2 = ticks();
+    if (t1 - t0 < best_single) best_single = t1 - t0;
+    if (t2 - t1 < best_bank)   best_bank = t2 - t1;
+    sink = single[0]->value() + bank.value(0);
+  }
+  (void)sink;
+
+  float worst = 0;
+  for (int c=0 ; c<CH ; c++) {
+    float e = fabsf(single[c]->value() - bank.value(c));
+    if (e > worst) worst = e;
+    delete single[c];
+  }
+  printf("9 x EMA  %6.2f %s/frame\n", double(best_single) / FRAMES, tick_unit);
+  printf("EMABank  %6.2f %s/frame   max difference %.2e\n", double(best_bank) / FRAMES, tick_unit, worst);
+}
+
+// update(sample) in a loop vs. update(samples, n, out), cycles per sample
+static void bench_batch(const std::vector<float>& xf) {
+  std::vector<float> a(SAMPLES), b(SAMPLES);
+  unsigned long long best_loop = ~0ull, best_batch = ~0ull;
+  for (int r=0 ; r<ROUNDS ; r++) {
+    EMA one(PERIODS, PERIODS), many(PERIODS, PERIODS);
+    unsigned long long t0 = ticks();
+    for (int i=0 ; i<SAMPLES ; i++) a[i] = one.update(xf[i]);
+    unsigned long long t1 = ticks();
+    many.update(xf.data(), SAMPLES, b.data());
+    unsigned long long t2 = ticks();
+    if (t1 - t0 < best_loop)  best_loop = t1 - t0;
+    if (t2 - t1 < best_batch) best_batch = t2 - t1;
+  }
+  int mismatches = 0;
+  for (int i=0 ; i<SAMPLES ; i++) mismatches += (a[i] != b[i]);
+  printf("update() loop  %6.2f %s/sample\n", double(best_loop) / SAMPLES, tick_unit);
+  printf("batch update() %6.2f %s/sample   %d results differ\n", double(best_batch) / SAMPLES, tick_unit, mismatches);
+}
+
+// warm-up averaging, the old way: ema * n + sample, then divide
+static float old_warmup(float ema, float x, unsigned& n) {
+  ema = ema * n + x;
+  return ema / ++n;
+}
+
+static void bench_warmup(void) {
+  const U_INT N = 20000;
+  std::vector<float> x(N);
+  for (U_INT i=0 ; i<N ; i++) x[i] = 1000.0f + 0.001f * float(i % 97);
+  double exact = 0;
+  for (U_INT i=0 ; i<N ; i++) exact += x[i];
+  exact /= N;
+
+  unsigned long long best_old = ~0ull, best_sum = ~0ull, best_kahan = ~0ull;
+  float old_mean = 0, sum_mean = 0, kahan_mean = 0;
+  volatile float sink;   // every average is used, as EMA::update() returns it
+  for (int r=0 ; r<ROUNDS / 10 ; r++) {
+    unsigned long long t0 = ticks();
+    float ema = 0;
+    unsigned n = 0;
+    for (U_INT i=0 ; i<N ; i++) sink = ema = old_warmup(ema, x[i], n);
+    unsigned long long t1 = ticks();
+    ema_float_warmup<float, false> plain;
+    plain.clear();
+    for (U_INT i=0 ; i<N ; i++) sink = sum_mean = plain.add(x[i], i + 1);
+    unsigned long long t2 = ticks();
+    ema_float_warmup<float, true> kahan;
+    kahan.clear();
+    for (U_INT i=0 ; i<N ; i++) sink = kahan_mean = kahan.add(x[i], i + 1);
+    unsigned long long t3 = ticks();
+    old_mean = ema;
+    if (t1 - t0 < best_old)   best_old = t1 - t0;
+    if (t2 - t1 < best_sum)   best_sum = t2 - t1;
+    if (t3 - t2 < best_kahan) best_kahan = t3 - t2;
+  }
+  (void)sink;
+  printf("%u sample warm-up, mean %.6f\n", N, exact);
+  printf("old      %6.2f %s/sample   error %.2e\n", double(best_old) / N, tick_unit, fabs(old_mean - exact));
+  printf("sum      %6.2f %s/sample   error %.2e\n", double(best_sum) / N, tick_unit, fabs(sum_mean - exact));
+  printf("kahan    %6.2f %s/sample   error %.2e\n", double(best_kahan) / N, tick_unit, fabs(kahan_mean - exact));
+}
+
+// TimedEMA: steady dt, jittered dt, and jittered dt with expf()
+static void bench_timed(const std::vector<float>& xf) {
+  const uint32_t DT = 1000;
+  std::vector<uint32_t> jitter(SAMPLES);
+  unsigned seed = 7;
+  for (int i=0 ; i<SAMPLES ; i++) {
+    seed = seed * 1103515245u + 12345u;
+    jitter[i] = DT - 100 + (seed >> 16) % 200;
+  }
+  unsigned long long best_steady = ~0ull, best_jitter = ~0ull, best_expf = ~0ull;
+  float worst = 0;
+  volatile float sink = 0;
+  for (int r=0 ; r<ROUNDS ; r++) {
+    TimedEMA steady(PERIODS, DT, PERIODS), jittered(PERIODS, DT, PERIODS);
+    float inv_tau = 1 / steady.getTau(), ema = 0;
+    unsigned long long t0 = ticks();
+    for (int i=0 ; i<SAMPLES ; i++) steady.update(xf[i], DT);
+    unsigned long long t1 = ticks();
+    for (int i=0 ; i<SAMPLES ; i++) jittered.update(xf[i], jitter[i]);
+    unsigned long long t2 = ticks();
+    for (int i=0 ; i<SAMPLES ; i++) ema += (1 - expf(-float(jitter[i]) * inv_tau)) * (xf[i] - ema);
+    unsigned long long t3 = ticks();
+    if (t1 - t0 < best_steady) best_steady = t1 - t0;
+    if (t2 - t1 < best_jitter) best_jitter = t2 - t1;
+    if (t3 - t2 < best_expf)   best_expf = t3 - t2;
+    sink = steady.value() + ema;
+    worst = fabsf(jittered.value() - ema);
+  }
+  (void)sink;
+  printf("TimedEMA steady  %6.2f %s/update\n", double(best_steady) / SAMPLES, tick_unit);
+  printf("TimedEMA jitter  %6.2f %s/update\n", double(best_jitter) / SAMPLES, tick_unit);
+  printf("expf() jitter    %6.2f %s/update   final difference %.2e\n", double(best_expf) / SAMPLES, tick_unit, worst);
+}
+
+// int16 counts: to float then EMA, vs. RawEMA
+static void bench_raw(const std::vector<int16_t>& x15) {
+  const float scale = 1.0f / 16384;
+  unsigned long long best_float = ~0ull, best_raw = ~0ull;
+  float worst = 0;
+  volatile float sink = 0;
+  for (int r=0 ; r<ROUNDS ; r++) {
+    EMA f(PERIODS, PERIODS);
+    RawEMA raw(PERIODS, PERIODS, scale);
+    unsigned long long t0 = ticks();
+    for (int i=0 ; i<SAMPLES ; i++) f.update(float(x15[i]) * scale);
+    unsigned long long t1 = ticks();
+    for (int i=0 ; i<SAMPLES ; i++) raw.update(x15[i]);
+    float out = raw.scaled();
+    unsigned long long t2 = ticks();
+    if (t1 - t0 < best_float) best_float = t1 - t0;
+    if (t2 - t1 < best_raw)   best_raw = t2 - t1;
+    sink = f.value() + out;
+    worst = fabsf(f.value() - out);
+  }
+  (void)sink;
+  printf("int16 to EMA     %6.2f %s/update\n", double(best_float) / SAMPLES, tick_unit);
+  printf("RawEMA           %6.2f %s/update   final difference %.2e\n", double(best_raw) / SAMPLES, tick_unit, worst);
+}
+
+int main(void) {
+  std::vector<double> x = input();
+  std::vector<double> ref(SAMPLES);
+  BasicEMA<double> reference(PERIODS, PERIODS);
+  for (int i=0 ; i<SAMPLES ; i++) ref[i] = reference.update(x[i]);
+
+  std::vector<float>   xf(x.begin(), x.end());
+  std::vector<int16_t> x15(SAMPLES);
+  std::vector<int32_t> x31(SAMPLES);
+  for (int i=0 ; i<SAMPLES ; i++) {
+    x15[i] = ema_traits<Q15>::from_float(xf[i]);
+    x31[i] = ema_traits<Q31>::from_float(xf[i]);
+  }
+
+  printf("%d samples, %u periods, best of %d runs\n", SAMPLES, PERIODS, ROUNDS);
+  bench<float>("float", xf, ref, from_f);
+  bench<double>("double", x, ref, from_d);
+  bench<Q15>("Q15", x15, ref, from_q15);
+  bench<Q31>("Q31", x31, ref, from_q31);
+  bench_bank(xf);
+  bench_batch(xf);
+  bench_warmup();
+  bench_timed(xf);
+  bench_raw(x15);
+  return 0;
+}
@@ -0,0 +1,120 @@
+/****************************************************************************
+ * ema_scan - re-filter a recorded log with EMA on every core.
+ *
+ * Reads raw little-endian float32 samples (one channel), filters them with
+ * the library's EMA using ema_scan(), and writes float32 results. With -b
+ * it also runs the serial EMA::update() over the same data and reports
+ * both times and the largest difference.
+ *
+ * Build and run on Linux:
+ *   g++ -O2 -pthread -I../.. ema_scan.cpp ../../EMA.cpp -o ema_scan
+ *   ./ema_scan -p 100 -a 10 imu_ax.f32 imu_ax_ema.f32
+ *   ./ema_scan -b -p 100 imu_ax.f32          # compare with serial
+ *   ./ema_scan -b -n 100000000               # ...on a synthetic signal
+ *
+ * Options:
+ *   -p periods    EMA periods (default 15)
+ *   -a samples    samples to average for warm-up (default = periods)
+ *   -j threads    worker threads (default: one per core)
+ *   -b            benchmark against the serial update()
+ *   -n samples    use a noisy sine of this many samples instead of a file
+ ****************************************************************************/
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <vector>
+
+#include "EMA.h"
+#include "ema_scan.h"
+
+static double seconds (void) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool read_samples (const char* path, std::vector<float>& x) {
+  FILE* f = fopen(path, "rb");
+  if (not f) return false;
+  float buf[4096];
+  size_t got;
+  while ((got = fread(buf, sizeof(float), 4096, f)) > 0) x.insert(x.end(), buf, buf + got);
+  fclose(f);
+  return true;
+}
+
+static void usage (void) {
+  fprintf(stderr, "usage: ema_scan [-p periods] [-a samples] [-j threads] [-b] [-n samples] [in.f32 [out.f32]]\n");
+  exit(2);
+}
+
+int main (int argc, char** argv) {
+  U_INT periods = 15;
+  long warmup = -1, synthetic = 0;
+  unsigned threads = 0;
+  bool bench = false;
+  int opt;
+  while ((opt = getopt(argc, argv, "p:a:j:bn:")) != -1) {
+    switch (opt) {
+      case 'p': periods = (U_INT)atol(optarg);   break;
+      case 'a': warmup = atol(optarg);            break;
+      case 'j': threads = unsigned(atoi(optarg)); break;
+      case 'b': bench = true;                     break;
+      case 'n': synthetic = atol(optarg);         break;
+      default: usage();
+    }
+  }
+  U_INT to_avg = warmup < 0 ? periods : (U_INT)warmup;
+
+  std::vector<float> x;
+  if (synthetic > 0) {
+    x.resize(size_t(synthetic));
+    unsigned seed = 1;
+    for (size_t i=0 ; i<x.size() ; i++) {
+      seed = seed * 1103515245u + 12345u;
+      x[i] = float(sin(i * 1e-4) + 0.2 * (((seed >> 16) & 0x7FFF) / 32768.0 - 0.5));
+    }
+  } else {
+    if (optind >= argc) usage();
+    if (not read_samples(argv[optind], x)) {
+      perror(argv[optind]);
+      return 1;
+    }
+    optind++;
+  }
+
+  EMAScanPool pool(threads);
+  std::vector<float> y(x.size());
+  EMA ema(periods, to_avg);
+  double t0 = seconds();
+  ema_scan(ema, x.data(), y.data(), x.size(), pool);
+  double t1 = seconds();
+
+  if (bench) {
+    std::vector<float> ref(x.size());
+    EMA serial(periods, to_avg);
+    double t2 = seconds();
+    serial.update(x.data(), x.size(), ref.data());
+    double t3 = seconds();
+    double worst = 0;
+    for (size_t i=0 ; i<x.size() ; i++) {
+      double e = fabs(double(y[i]) - ref[i]) / (fabs(ref[i]) > 1 ? fabs(ref[i]) : 1);
+      if (e > worst) worst = e;
+    }
+    fprintf(stderr, "%zu samples, %u periods, %u threads\n", x.size(), periods, pool.threads());
+    fprintf(stderr, "serial   %8.1f ms\n", (t3 - t2) * 1e3);
+    fprintf(stderr, "ema_scan %8.1f ms   %.2fx   max difference %.2e\n",
+            (t1 - t0) * 1e3, (t3 - t2) / (t1 - t0), worst);
+  }
+
+  if (optind < argc) {
+    FILE* f = fopen(argv[optind], "wb");
+    if (not f or fwrite(y.data(), sizeof(float), y.size(), f) != y.size()) {
+      perror(argv[optind]);
+      return 1;
+    }
+    fclose(f);
+  }
+  return 0;
+}
@@ -0,0 +1,166 @@
+/****************************************************************************
+ * ema_scan() - parallel EMA over a large buffer, for host tools.
+ *
+ * After warm-up the EMA is a linear recurrence, y[i] = a y[i-1] + k x[i]
+ * with a = 1 - k, so a chunk of samples run from a start value y0 ends at
+ * z + a^len y0, where z is the chunk run from 0. The buffer is split into
+ * chunks and filtered in three passes:
+ *
+ *   1. each chunk is run from 0 to get z, in parallel
+ *   2. the chunk start values are chained through z and a^len, serially
+ *   3. each chunk is run again from its true start, in parallel
+ *
+ * Samples more than m back, where a^m < 2^-40, no longer show in a float
+ * result, so pass 1 only runs the last m samples of each chunk - about
+ * 10 x periods. Pass 3 does nearly all the work and scales with the cores.
+ *
+ * Pass 3 is BasicEMA's own batch update(), so each result differs from the
+ * serial update() only by the rounding in its chunk's start value, which
+ * decays by a every sample. Warm-up averaging runs serially first.
+ *
+ * Needs C++11 threads - host builds only, not for the Arduino library.
+ *
+ *   EMA ema(100, 10);
+ *   EMAScanPool pool;                     // one worker per core
+ *   ema_scan(ema, x, y, n, pool);         // like ema.update(x, n, y)
+ ****************************************************************************/
+
+#ifndef EMA_SCAN_H
+#define EMA_SCAN_H
+
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "EMA.h"
+
+// fixed pool of worker threads that run the tasks of one job at a time
+class EMAScanPool {
+ public:
+
+  explicit EMAScanPool (unsigned n_threads = 0) {
+    if (not n_threads) n_threads = std::thread::hardware_concurrency();
+    if (not n_threads) n_threads = 1;
+    for (unsigned i=1 ; i<n_threads ; i++) workers.emplace_back(&EMAScanPool::_work, this);
+  }
+
+  ~EMAScanPool (void) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& t : workers) t.join();
+  }
+
+  unsigned threads (void) const { return unsigned(workers.size()) + 1; }
+
+  // run task(0) .. task(n-1) on the pool and the calling thread, returns
+  // when all are done
+  void run (size_t n, const std::function<void(size_t)>& task) {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      job = &task;
+      n_tasks = n;
+      next = 0;
+      busy = workers.size();
+      generation++;
+    }
+    wake.notify_all();
+    _drain();
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [this] { return busy == 0; });
+    job = nullptr;
+  }
+
+ private:
+
+  void _drain (void) {
+    for (size_t i ; (i = next++) < n_tasks ; ) (*job)(i);
+  }
+
+  void _work (void) {
+    unsigned long seen = 0;
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [&] { return stopping or generation != seen; });
+        if (stopping) return;
+        seen = generation;
+      }
+      _drain();
+      std::lock_guard<std::mutex> lock(mutex);
+      if (--busy == 0) finished.notify_one();
+    }
+  }
+
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable wake, finished;
+  const std::function<void(size_t)>* job = nullptr;
+  size_t n_tasks = 0;
+  std::atomic<size_t> next{0};
+  size_t busy = 0;
+  unsigned long generation = 0;
+  bool stopping = false;
+};
+
+#define EMA_SCAN_MIN_CHUNK  (1 << 16)   // smaller buffers aren't worth a thread
+
+/*
+ * Filter n samples of x with ema, writing each result to y, as
+ * ema.update(x, n, y) does, and leave ema in the same final state.
+ * Float and double only: the fixed-point steps round, so they aren't
+ * linear and can't be split.
+ */
+template <typename T>
+typename BasicEMA<T>::sample_t ema_scan (BasicEMA<T>& ema, const T* x, T* y, size_t n, EMAScanPool& pool) {
+  static_assert(not ema_traits<T>::fixed_point, "ema_scan() needs a float or double EMA");
+
+  size_t i = 0;
+  for ( ; i < n and not ema.in_ema_mode() ; i++) y[i] = ema.update(x[i]);
+  x += i;
+  y += i;
+  n -= i;
+
+  size_t chunks = pool.threads() > 1 ? pool.threads() * 4 : 1;
+  if (n / chunks < EMA_SCAN_MIN_CHUNK) chunks = n / EMA_SCAN_MIN_CHUNK;
+  if (chunks < 2) return ema.update(x, n, y);
+
+  const U_INT periods = ema.getPeriods();
+  const double a = 1 - double(ema_traits<T>::coef(periods));
+  const size_t len = (n + chunks - 1) / chunks;
+  chunks = (n + len - 1) / len;
+  const size_t tail = a > 0 ? size_t(ceil(-40 * log(2.0) / log(a))) : 1;   // a^tail < 2^-40
+  std::vector<T> start(chunks), end(chunks);
+
+  pool.run(chunks, [&](size_t c) {
+    size_t lo = c * len, hi = lo + len < n ? lo + len : n;
+    if (hi - lo > tail) lo = hi - tail;
+    BasicEMA<T> local(periods, 0);
+    local.value(0);
+    end[c] = local.update(x + lo, hi - lo);
+  });
+
+  // a^len by squaring; the last chunk may be shorter but its end isn't used
+  double a_len = 1, p = a;
+  for (size_t e = len ; e ; e >>= 1, p *= p) if (e & 1) a_len *= p;
+  start[0] = ema.value();
+  for (size_t c=1 ; c<chunks ; c++) start[c] = T(double(end[c - 1]) + a_len * double(start[c - 1]));
+
+  pool.run(chunks, [&](size_t c) {
+    size_t lo = c * len, hi = lo + len < n ? lo + len : n;
+    BasicEMA<T> local(periods, 0);
+    local.value(start[c]);
+    end[c] = local.update(x + lo, hi - lo, y + lo);
+  });
+
+  ema.value(end[chunks - 1]);
+  return ema.value();
+}
+
+#endif /* _H */
@@ -0,0 +1,96 @@
+/****************************************************************************
+ * Host micro-benchmark: pPlotFormat vs. the old String(float) path.
+ *
+ * Formats a 9-channel IMU-style frame ("ax=0.12:0.12,ay=...") both ways
+ * and reports nanoseconds per frame. The String path is modelled with
+ * std::string temporaries and snprintf("%.2f"), which is what String(float)
+ * and dtostrf() boil down to on the SAMD and ESP cores.
+ *
+ * Build and run on Linux:
+ *   g++ -O2 -I../.. bench_format.cpp -o bench_format && ./bench_format
+ *
+ * Host numbers only show the relative cost. On a Cortex-M0+ the gap is
+ * wider since printf's float path is all software double math.
+ ****************************************************************************/
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "pPlotFormat.h"
+
+static const char* labels[9] = { "ax", "ay", "az", "gx", "gy", "gz", "mx", "my", "mz" };
+static const int FRAMES = 200000;
+
+static float sample(int frame, int ch) {
+  return (float(frame % 2000) - 1000.0f) * 0.0137f * (ch + 1);
+}
+
+// std::string + snprintf - one heap temporary per piece like String
+static size_t string_frame(int frame, std::string& out) {
+  out = "";
+  for (int ch=0 ; ch<9 ; ch++) {
+    char tmp[48];
+    float v = sample(frame, ch);
+    if (out.length()) out += std::string(",");
+    out += labels[ch];
+    snprintf(tmp, sizeof(tmp), "%.2f", v);
+    out += (std::string("=") + tmp);
+    out += (std::string(":") + tmp);
+  }
+  return out.length();
+}
+
+// pPlotFormat into a fixed buffer
+static size_t fixed_frame(int frame, char* buf, size_t size) {
+  size_t len = 0;
+  for (int ch=0 ; ch<9 ; ch++) {
+    float v = sample(frame, ch);
+    if (len) buf[len++] = ',';
+    len += plot_format_str(buf + len, size - len, labels[ch]);
+    buf[len++] = '=';
+    len += plot_format_float(buf + len, size - len, v, 2);
+    buf[len++] = ':';
+    len += plot_format_float(buf + len, size - len, v, 2);
+  }
+  return len;
+}
+
+template <typename F>
+static double time_ns(F fn) {
+  auto start = std::chrono::steady_clock::now();
+  size_t total = 0;
+  for (int f=0 ; f<FRAMES ; f++) total += fn(f);
+  auto stop = std::chrono::steady_clock::now();
+  if (total == 0) printf("?");  // keep the work observable
+  return std::chrono::duration<double, std::nano>(stop - start).count() / FRAMES;
+}
+
+int main(void) {
+  std::string s;
+  char buf[256];
+
+  // every formatted value must round to within half a unit of the last place
+  // (it can differ from printf by one count when float scaling lands on .5)
+  for (int f=0 ; f<FRAMES ; f++) {
+    for (int ch=0 ; ch<9 ; ch++) {
+      float v = sample(f, ch);
+      plot_format_float(buf, sizeof(buf), v, 2);
+      if (fabs(strtod(buf, NULL) - v) > 0.00501) {
+        printf("bad value %.6f -> %s\n", v, buf);
+        return 1;
+      }
+    }
+  }
+
+  double t_string = time_ns([&](int f) { return string_frame(f, s); });
+  double t_fixed  = time_ns([&](int f) { return fixed_frame(f, buf, sizeof(buf)); });
+
+  printf("9-channel frame, %d frames\n", FRAMES);
+  printf("  String path : %8.1f ns/frame\n", t_string);
+  printf("  pPlotFormat : %8.1f ns/frame  (%.1fx)\n", t_fixed, t_string / t_fixed);
+  return 0;
+}
@@ -0,0 +1,331 @@
+/****************************************************************************
+ * plot_decode - turn a Plot binary mode stream back into text.
+ *
+ * Reads COBS framed Plot packets (see pPlotCodec.h) from a file, a serial
+ * device or stdin and writes Serial Plotter text lines, or CSV with a
+ * header row each time the series or their labels change (not when the
+ * same schema is resent). PLOT_DELTA streams are rebuilt from their key
+ * and delta packets to the exact quantized values.
+ * With -t, CSV gets a first column of seconds from the first timestamped
+ * frame (see Plot::timestamps()). -x checks that CSV keeps the exact
+ * quantized values for a set of resolutions, including non-decade ones
+ * like 0.25, and exits.
+ *
+ * Build on Linux:
+ *   g++ -O2 -I../.. plot_decode.cpp -o plot_decode
+ *
+ * Usage:
+ *   plot_decode [-c [-t]] [-p decimals] [input]
+ *   plot_decode -x
+ *     -c           write CSV instead of plotter text
+ *     -t           add a time column to the CSV
+ *     -p decimals  decimal places for float values in plotter text (2)
+ *     -x           run the CSV round-trip check
+ *     input        file or serial device, default stdin
+ *
+ *   stty -F /dev/ttyACM0 115200 raw && plot_decode /dev/ttyACM0
+ ****************************************************************************/
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+#include "pPlotCodec.h"
+
+struct SeriesInfo {
+  uint8_t     type;
+  bool        value_in_label;
+  float       offset;
+  float       resolution;  // PLOT_DELTA step
+  int         places;      // ... as decimal places, for CSV
+  std::string label;
+};
+
+struct Schema {
+  bool    valid = false;
+  uint8_t id = 0;
+  bool    constrained = false;
+  bool    quantized = false;
+  bool    timestamped = false;
+  float   vmin = 0, vmax = 0;
+  std::vector<SeriesInfo> series;
+};
+
+static Schema schema;
+static bool   csv = false;
+static bool   csv_header_due = true;
+static bool   time_column = false;
+static int    decimals = PLOT_DEFAULT_DECIMALS;
+static unsigned long bad_packets = 0, skipped_frames = 0;
+
+// PLOT_DELTA reference - the last values rebuilt, valid after a key
+static std::vector<int32_t> last_q;
+static bool    have_key = false;
+static uint8_t next_seq = 0;
+
+// frame time, unwrapped to 64 bits
+static uint64_t now_us = 0, start_us = 0;
+static bool     have_time = false, stamp_whole = true;
+
+// decimal places that show every multiple of a resolution exactly: the
+// fewest p for which resolution * 10^p is a whole number, at most 9
+static int decimal_places(float resolution) {
+  double r = fabs(resolution);
+  int p = 0;
+  for ( ; p < 9 ; p++, r *= 10) {
+    if (fabs(r - floor(r + 0.5)) <= 1e-6 * r) break;
+  }
+  return p;
+}
+
+// same series count and labels, so the CSV header still fits
+static bool same_labels(const Schema& a, const Schema& b) {
+  if (not a.valid or not b.valid or a.series.size() != b.series.size()) return false;
+  for (size_t k=0 ; k<a.series.size() ; k++) {
+    if (a.series[k].label != b.series[k].label) return false;
+  }
+  return true;
+}
+
+static bool parse_schema(const uint8_t* p, size_t n) {
+  if (n < PLOT_SCHEMA_HEADER_LEN) return false;
+  Schema s;
+  s.id = p[1];
+  uint8_t count = p[2];
+  s.constrained = p[3] & PLOT_FLG_CONSTRAINED;
+  s.quantized = p[3] & PLOT_FLG_QUANTIZED;
+  s.timestamped = p[3] & PLOT_FLG_TIMESTAMP;
+  s.vmin = plot_get_f32(p + 4);
+  s.vmax = plot_get_f32(p + 8);
+  size_t i = PLOT_SCHEMA_HEADER_LEN;
+  for (uint8_t k=0 ; k<count ; k++) {
+    if (i + PLOT_SCHEMA_SERIES_LEN > n) return false;
+    SeriesInfo info;
+    info.type = p[i] & PLOT_TYPE_MASK;
+    info.value_in_label = p[i] & PLOT_FLG_VALUE_IN_LABEL;
+    info.offset = plot_get_f32(p + i + 1);
+    size_t label_len = p[i + 5];
+    i += PLOT_SCHEMA_SERIES_LEN;
+    if (i + label_len > n) return false;
+    info.label.assign((const char*)p + i, label_len);
+    i += label_len;
+    info.resolution = 1;
+    s.series.push_back(info);
+  }
+  if (s.quantized) {
+    if (i + 4 * count > n) return false;
+    for (uint8_t k=0 ; k<count ; k++, i += 4) {
+      SeriesInfo& info = s.series[k];
+      info.resolution = plot_get_f32(p + i);
+      info.places = decimal_places(info.resolution);
+    }
+  }
+  s.valid = true;
+  if (not same_labels(s, schema)) csv_header_due = true;  // a resent schema keeps one table
+  schema = s;
+  have_key = false;
+  stamp_whole = true;
+  return true;
+}
+
+// read a packet's timestamp at p + i, if the schema has them
+static bool parse_stamp(const uint8_t* p, size_t n, size_t& i, bool whole) {
+  if (not schema.timestamped) return true;
+  uint32_t stamp;
+  size_t used = plot_get_varint(p + i, n - i, stamp);
+  if (not used) return false;
+  i += used;
+  if (not whole) {
+    now_us += stamp;
+  } else if (have_time) {
+    now_us += uint32_t(stamp - uint32_t(now_us));  // micros() wraps every ~71 minutes
+  } else {
+    now_us = start_us = stamp;
+    have_time = true;
+  }
+  stamp_whole = false;
+  return true;
+}
+
+static std::string format(const PlotValue& v, int places) {
+  char buf[32];
+  plot_format_value(buf, sizeof(buf), v, places);
+  return buf;
+}
+
+static void write_text(const std::vector<PlotValue>& values) {
+  std::string line;
+  for (size_t k=0 ; k<values.size() ; k++) {
+    const SeriesInfo& info = schema.series[k];
+    if (k) line += ",";
+    line += info.label;
+    if (info.value_in_label) line += "=" + format(values[k], decimals);
+    PlotValue graph = values[k];
+    if (graph.is_int() and not schema.constrained and info.offset == int32_t(info.offset)) {
+      graph.i += int32_t(info.offset);
+    } else {
+      float g = graph.as_float() + info.offset;
+      if (schema.constrained) g = (g < schema.vmin) ? schema.vmin : (g > schema.vmax) ? schema.vmax : g;
+      graph.type = PLOT_F32;
+      graph.f = g;
+    }
+    line += ":" + format(graph, decimals);
+  }
+  puts(line.c_str());
+}
+
+static void write_csv(const std::vector<PlotValue>& values) {
+  if (csv_header_due) {
+    if (time_column) printf("t_s,");
+    for (size_t k=0 ; k<schema.series.size() ; k++) {
+      printf("%s%s", k ? "," : "", schema.series[k].label.c_str());
+    }
+    printf("\n");
+    csv_header_due = false;
+  }
+  if (time_column) printf("%.6f,", have_time ? (now_us - start_us) * 1e-6 : 0.0);
+  for (size_t k=0 ; k<values.size() ; k++) {
+    if (values[k].is_int())    printf("%s%ld", k ? "," : "", (long)values[k].i);
+    else if (schema.quantized) printf("%s%.*f", k ? "," : "", schema.series[k].places, values[k].f);
+    else                       printf("%s%.9g", k ? "," : "", values[k].f);
+  }
+  printf("\n");
+}
+
+static void write_values(const std::vector<PlotValue>& values) {
+  if (csv) write_csv(values);
+  else     write_text(values);
+}
+
+static bool parse_data(const uint8_t* p, size_t n) {
+  if (not schema.valid or p[1] != schema.id) {
+    skipped_frames++;  // joined mid-stream, wait for the next schema
+    return true;
+  }
+  std::vector<PlotValue> values(schema.series.size());
+  size_t i = 2;
+  if (not parse_stamp(p, n, i, stamp_whole)) return false;
+  for (size_t k=0 ; k<values.size() ; k++) {
+    if (i + plot_type_size(schema.series[k].type) > n) return false;
+    i += plot_get_value(p + i, schema.series[k].type, values[k]);
+  }
+  write_values(values);
+  return true;
+}
+
+static bool parse_delta(const uint8_t* p, size_t n) {
+  bool key = (p[0] == PLOT_PKT_KEY);
+  if (n < 3 or not schema.valid or not schema.quantized or p[1] != schema.id
+      or (not key and (not have_key or p[2] != next_seq))) {
+    have_key = false;  // lost the reference, wait for the next key
+    skipped_frames++;
+    return n >= 3;
+  }
+  size_t count = schema.series.size();
+  std::vector<int32_t> q(count);
+  std::vector<PlotValue> values(count);
+  size_t i = 3;
+  if (not parse_stamp(p, n, i, key)) return false;
+  for (size_t k=0 ; k<count ; k++) {
+    uint32_t u;
+    size_t used = plot_get_varint(p + i, n - i, u);
+    if (not used) return false;
+    i += used;
+    int32_t d = plot_unzigzag(u);
+    q[k] = key ? d : int32_t(uint32_t(last_q[k]) + uint32_t(d));
+    const SeriesInfo& info = schema.series[k];
+    if (info.resolution == 1 and info.type != PLOT_F32) {
+      values[k].type = PLOT_I32;
+      values[k].i = q[k];
+    } else {
+      values[k].type = PLOT_F32;
+      values[k].f = q[k] * info.resolution;
+    }
+  }
+  last_q = q;
+  have_key = true;
+  next_seq = p[2] + 1;
+  write_values(values);
+  return true;
+}
+
+// -x: print the values parse_delta() rebuilds the way write_csv() does,
+// read them back and requantize; every q must come back unchanged
+static int check_round_trip(void) {
+  static const float resolutions[] = { 1, 0.5f, 0.25f, 0.125f, 0.1f, 0.05f, 0.02f, 0.01f, 0.001f, 2.5f };
+  unsigned long failed = 0;
+  for (float res : resolutions) {
+    int places = decimal_places(res);
+    for (int32_t q = -100000 ; q <= 100000 ; q++) {
+      char buf[32];
+      snprintf(buf, sizeof(buf), "%.*f", places, double(q * res));
+      long back = lround(strtod(buf, NULL) / res);
+      if (back != q and failed++ < 10) {
+        fprintf(stderr, "resolution %g, q %ld: wrote %s, read back %ld\n", res, (long)q, buf, back);
+      }
+    }
+    printf("resolution %-6g %d places\n", res, places);
+  }
+  printf("%lu values differ\n", failed);
+  return failed ? 1 : 0;
+}
+
+static void handle_packet(const std::vector<uint8_t>& encoded) {
+  if (encoded.empty()) return;
+  std::vector<uint8_t> raw(encoded.size());
+  size_t n = plot_cobs_decode(encoded.data(), encoded.size(), raw.data());
+  bool ok = false;
+  if (n >= 2) {
+    switch (raw[0]) {
+      case PLOT_PKT_SCHEMA: ok = parse_schema(raw.data(), n); break;
+      case PLOT_PKT_DATA:   ok = parse_data(raw.data(), n);   break;
+      case PLOT_PKT_KEY:
+      case PLOT_PKT_DELTA:  ok = parse_delta(raw.data(), n);  break;
+    }
+  }
+  if (not ok) bad_packets++;
+}
+
+int main(int argc, char** argv) {
+  int opt;
+  while ((opt = getopt(argc, argv, "ctp:x")) != -1) {
+    switch (opt) {
+      case 'c': csv = true; break;
+      case 't': time_column = true; break;
+      case 'p': decimals = atoi(optarg); break;
+      case 'x': return check_round_trip();
+      default:
+        fprintf(stderr, "usage: %s [-c [-t]] [-p decimals] [-x] [input]\n", argv[0]);
+        return 2;
+    }
+  }
+  FILE* in = stdin;
+  if (optind < argc) {
+    in = fopen(argv[optind], "rb");
+    if (not in) {
+      perror(argv[optind]);
+      return 1;
+    }
+  }
+
+  if (isatty(fileno(in))) setvbuf(stdout, NULL, _IOLBF, 0);  // live device
+
+  std::vector<uint8_t> packet;
+  int c;
+  while ((c = fgetc(in)) != EOF) {
+    if (c == 0) {
+      handle_packet(packet);
+      packet.clear();
+    } else {
+      packet.push_back(uint8_t(c));
+    }
+  }
+  if (bad_packets or skipped_frames) {
+    fprintf(stderr, "%lu bad packets, %lu frames without a schema or key\n", bad_packets, skipped_frames);
+  }
+  return 0;
+}
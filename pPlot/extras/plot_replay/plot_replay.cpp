@@ -0,0 +1,154 @@
+/****************************************************************************
+ * plot_replay - play back a captured Plot binary stream with its timing.
+ *
+ * Reads a log of COBS framed Plot packets (see pPlotCodec.h) recorded with
+ * Plot::timestamps() on, and writes the packets to stdout spaced as they
+ * were sent, or speed times faster. Pipe it into plot_decode for plotter
+ * text, or redirect it to a serial device or pty to rerun a session
+ * through other code. Packets without a timestamp go out immediately.
+ * With -j it prints the frame interval statistics
+ * instead, to measure loop jitter offline.
+ *
+ * Build on Linux:
+ *   g++ -O2 -I../.. plot_replay.cpp -o plot_replay
+ *
+ * Usage:
+ *   plot_replay [-s speed | -j] [input]
+ *     -s speed  playback speed, 2 is twice as fast, 0 as fast as possible (1)
+ *     -j        print interval statistics instead of replaying
+ *     input     log file, default stdin
+ *
+ *   cat /dev/ttyACM0 > session.bin          # capture
+ *   plot_replay session.bin | plot_decode   # watch it again in real time
+ *   plot_decode -c -t session.bin           # CSV with a time column
+ ****************************************************************************/
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+#include <unistd.h>
+
+#include "pPlotCodec.h"
+
+static bool     timestamped = false;
+static bool     stamp_whole = true;
+static bool     have_time = false;
+static uint64_t now_us = 0;
+
+// the packet's frame time in now_us; false for packets without one
+static bool packet_time(const std::vector<uint8_t>& encoded) {
+  std::vector<uint8_t> raw(encoded.size());
+  size_t n = plot_cobs_decode(encoded.data(), encoded.size(), raw.data());
+  if (n < 2) return false;
+  size_t i;
+  bool whole;
+  switch (raw[0]) {
+    case PLOT_PKT_SCHEMA:
+      if (n < PLOT_SCHEMA_HEADER_LEN) return false;
+      timestamped = raw[3] & PLOT_FLG_TIMESTAMP;
+      stamp_whole = true;
+      return false;
+    case PLOT_PKT_DATA:  i = 2;  whole = stamp_whole;              break;
+    case PLOT_PKT_KEY:   i = 3;  whole = true;                     break;
+    case PLOT_PKT_DELTA: i = 3;  whole = false;                    break;
+    default:             return false;
+  }
+  uint32_t stamp;
+  if (not timestamped or i >= n or not plot_get_varint(raw.data() + i, n - i, stamp)) return false;
+  if (not whole)      now_us += stamp;
+  else if (have_time) now_us += uint32_t(stamp - uint32_t(now_us));
+  else                now_us = stamp;
+  have_time = true;
+  stamp_whole = false;
+  return true;
+}
+
+static uint64_t wall_us(void) {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return uint64_t(ts.tv_sec) * 1000000u + ts.tv_nsec / 1000;
+}
+
+static void sleep_until(uint64_t us) {
+  timespec ts;
+  ts.tv_sec  = us / 1000000u;
+  ts.tv_nsec = (us % 1000000u) * 1000;
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL)) {}
+}
+
+int main(int argc, char** argv) {
+  double speed = 1;
+  bool jitter = false;
+  int opt;
+  while ((opt = getopt(argc, argv, "s:j")) != -1) {
+    switch (opt) {
+      case 's': speed = atof(optarg); break;
+      case 'j': jitter = true; break;
+      default:
+        fprintf(stderr, "usage: %s [-s speed | -j] [input]\n", argv[0]);
+        return 2;
+    }
+  }
+  FILE* in = stdin;
+  if (optind < argc) {
+    in = fopen(argv[optind], "rb");
+    if (not in) {
+      perror(argv[optind]);
+      return 1;
+    }
+  }
+
+  bool started = false;
+  uint64_t first_us = 0, wall_start = 0, last_us = 0;
+  unsigned long frames = 0;
+  double sum = 0, sum_sq = 0, dt_min = 0, dt_max = 0;
+
+  std::vector<uint8_t> packet;
+  int c;
+  while ((c = fgetc(in)) != EOF) {
+    if (c) {
+      packet.push_back(uint8_t(c));
+      continue;
+    }
+    if (packet.empty()) continue;
+    bool timed = packet_time(packet);
+    if (timed) {
+      if (not started) {
+        first_us = now_us;
+        wall_start = wall_us();
+        started = true;
+      } else {
+        double dt = double(now_us - last_us);
+        sum += dt;
+        sum_sq += dt * dt;
+        if (frames == 1 or dt < dt_min) dt_min = dt;
+        if (frames == 1 or dt > dt_max) dt_max = dt;
+      }
+      last_us = now_us;
+      frames++;
+    }
+    if (not jitter) {
+      if (timed and speed > 0) sleep_until(wall_start + uint64_t((now_us - first_us) / speed));
+      packet.push_back(0);
+      fwrite(packet.data(), 1, packet.size(), stdout);
+      fflush(stdout);
+    }
+    packet.clear();
+  }
+
+  if (jitter) {
+    if (frames < 2) {
+      fprintf(stderr, "need at least 2 timestamped frames\n");
+      return 1;
+    }
+    unsigned long n = frames - 1;
+    double mean = sum / n;
+    double sd = sqrt(sum_sq / n - mean * mean > 0 ? sum_sq / n - mean * mean : 0);
+    printf("frames    %lu over %.6f s\n", frames, (last_us - first_us) * 1e-6);
+    printf("interval  mean %.1f us, sd %.1f us, min %.0f us, max %.0f us\n", mean, sd, dt_min, dt_max);
+    printf("rate      %.2f frames/s\n", 1e6 / mean);
+  }
+  return 0;
+}
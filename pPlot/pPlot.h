@@ -3,6 +3,12 @@
 
 #include <Streaming.h>
 #include <String.h>
+#include "pPlotFormat.h"
+#include "pPlotCodec.h"
+#include "pPlotQueue.h"
+#include "pPlotFrame.h"
+#include "pPlotSnapshot.h"
+#include "pPlotCapture.h"
 
 /*****************************************************************************
  * Plot - Format a plotter string for use with the Arduino IDE's
@@ -41,29 +47,411 @@
  *  You can change graph sets interactively - just plot the same number of
  *  values. e.g, Plot (x,y,z) sets for gyroscope, accelerometer,
  *  magnetometer, and (pitch,roll,yaw) for IMS sensor fusion.
+ *
+ * Memory:
+ *  add() records each value and copies its label into fixed buffers, and
+ *  print() formats the frame straight into a fixed char buffer owned by
+ *  the instance, so no heap is used once the sketch is running. Plot is a
+ *  BasicPlot<PLOT_CAPACITY>; #define PLOT_CAPACITY before including pPlot.h,
+ *  or declare a BasicPlot<n> directly, if your frames need more room.
+ *  An item that doesn't fit is dropped whole and counted in overflows();
+ *  nothing else shows it, so check overflows() when adding series. 128
+ *  bytes holds ~6 float series with values in the labels - a 9-axis IMU
+ *  frame needs a BasicPlot<192, 9> or larger.
+ *
+ * Numbers:
+ *  Values are formatted by pPlotFormat.h without dtostrf() or String.
+ *  Integer values (e.g., Cirque xValue) take an integer-only path, and
+ *  floats use 2 decimal places unless changed with precision(n) for all
+ *  series or precision(i, n) for the ith series added to a frame.
+ *
+ * Binary mode:
+ *  mode(PLOT_BINARY) sends COBS framed packets (see pPlotCodec.h) instead of
+ *  text: a schema packet with the labels and types when the series change,
+ *  then packed float32/int16/int32 values for each frame. Use the
+ *  extras/plot_decode host tool to turn the stream back into plotter text
+ *  or CSV. send_schema() repeats the schema for a receiver that joins late.
+ *
+ * Delta mode:
+ *  mode(PLOT_DELTA) is binary mode for slowly changing series. Values are
+ *  quantized to resolution() steps and sent as zigzag varint changes from
+ *  the previous frame, usually 1 byte each, with a whole key frame every
+ *  keyframe_every() frames. plot_decode rebuilds the quantized values.
+ *
+ * Timestamps:
+ *  timestamps() adds each frame's print() time to binary and delta packets,
+ *  usually as a 1-2 byte varint change, so a captured log keeps the real
+ *  sample spacing. See extras/plot_replay.
+ *
+ * Header once:
+ *  Labels don't change between frames, so header_once() sends the labelled
+ *  line only when the series change and bare values ("0.48,2047,-3") in
+ *  between, which the Serial Plotter also accepts. header_once(n) repeats
+ *  the labels every n frames; header_always() restores the default.
+ *
+ * Non-blocking output:
+ *  print(queue) puts the frame into a PlotQueue ring buffer, and the
+ *  queue's service() method drains it as the stream has room, dropping
+ *  whole frames when it falls behind. See pPlotQueue.h.
+ *
+ * Decimation:
+ *  decimate(n) sends one frame per n print() calls. add() only records the
+ *  values; each print() folds them into every series' reduce() policy, in
+ *  constant time, and the nth sends the result: PLOT_KEEP_LAST (the
+ *  default), PLOT_AVERAGE, or PLOT_MIN_MAX, which reports the window's max
+ *  and min in turn so spikes still show up as an envelope.
+ *
+ * Throttling:
+ *  throttle(bytes_per_second) measures the print() rate and the bytes per
+ *  frame and raises or lowers decimate() to stay within the link's budget,
+ *  so the sketch never waits on a full transmit buffer. fps() and
+ *  bytes_per_second() report what's actually being sent.
+ *
+ * Multiple outputs:
+ *  add_sink(sink) sends each frame to a PlotSink too - another stream or a
+ *  PlotQueue - with its own mode(), decimate(), header_once() and a
+ *  PLOT_BLOCK or PLOT_DROP back-pressure policy. The frame is recorded
+ *  once and encoded for each output in turn; print() with no stream sends
+ *  to the sinks only.
+ *
+ * Interrupts:
+ *  Don't call add() from an ISR. Have the ISR write a PlotSnapshot
+ *  (pPlotSnapshot.h) and add the latest consistent values from loop().
+ *
+ * Triggered capture:
+ *  capture(scope) records frames into a PlotCapture (pPlotCapture.h) ring
+ *  instead of sending them. When a series crosses the trigger level, or
+ *  trigger() is called, it fills the post-trigger frames and print() sends
+ *  the whole window at full resolution, then stays quiet until re-armed.
+ *
+ * Fixed layouts:
+ *  For a frame whose series never change, PlotFrame (pPlotFrame.h) fixes
+ *  labels, offsets and precision at compile time and only formats numbers.
  *****************************************************************************/
 
-class Plot {
+#ifndef PLOT_CAPACITY
+#define PLOT_CAPACITY  128  // frame buffer size in bytes, incl. terminator
+                            // (~6 float series w/ values in labels)
+#endif
+
+// Per-series state is kept for every series slot, used or not: 37 bytes a
+// slot in a Plot (values, label index, precision, decimation and delta
+// state) and 16 in each PlotSink, on x86-64. sizeof(Plot) there is 952
+// bytes at 16 series: ~590 in series slots, the 128-byte frame buffer,
+// 64 bytes of labels, and pointers and counters. AVR defaults to 6 series,
+// ~31 bytes a slot; declare BasicPlot<CAPACITY, SERIES> for the series you
+// plot, e.g., BasicPlot<96, 4>, or #define PLOT_MAX_SERIES.
+#ifndef PLOT_MAX_SERIES
+#ifdef __AVR__
+#define PLOT_MAX_SERIES  6  // series per frame, on a 2 KB Uno
+#else
+#define PLOT_MAX_SERIES  16 // series per frame
+#endif
+#endif
+
+// the binary encoders each build a packet in a CAPACITY-byte stack buffer;
+// kept out of line so a text-mode print() doesn't reserve that stack too
+#if defined(__GNUC__)
+#define PLOT_NOINLINE  __attribute__((noinline))
+#else
+#define PLOT_NOINLINE
+#endif
+
+#define PLOT_MAX_DECIMATION  1000  // throttle() limit
+
+#define PLOT_KEYFRAME_INTERVAL  32  // PLOT_DELTA default
+
+#ifndef PLOT_LABEL_CAPACITY
+#define PLOT_LABEL_CAPACITY  64  // label characters per frame, incl. terminators
+#endif
+
+enum plot_reduce_t {
+  PLOT_KEEP_LAST,   // keep every nth sample
+  PLOT_AVERAGE,     // mean of the n samples
+  PLOT_MIN_MAX      // alternate max and min so the trace draws the envelope
+};
+
+enum plot_mode_t {
+  PLOT_TEXT,    // Serial Plotter text
+  PLOT_BINARY,  // COBS framed schema + data packets
+  PLOT_DELTA    // COBS framed schema + quantized key/delta packets
+};
+
+enum plot_backpressure_t {
+  PLOT_BLOCK,   // write the frame even if the stream has to wait
+  PLOT_DROP     // drop the frame if availableForWrite() is short
+};
+
+// add() label - accepts char strings and String objects
+struct PlotLabel {
+  PlotLabel(const char* s)   : str(s) {}
+  PlotLabel(const String& s) : str(s.c_str()) {}
+  const char* str;
+};
+
+template <size_t CAPACITY, uint8_t SERIES=PLOT_MAX_SERIES> class BasicPlot;
+
+/*
+ * PlotOutput - what one output sends and what it has sent: format,
+ * labels/schema, decimation, and the delta and timestamp references, for
+ * up to SERIES series. Plot is the output for print(os), and each PlotSink
+ * is another.
+ */
+template <uint8_t SERIES>
+class BasicPlotOutput {
+  template <size_t C, uint8_t S> friend class BasicPlot;
+
+ public:
+
+  BasicPlotOutput (void) {
+    reduce(PLOT_KEEP_LAST);
+  }
+
+  // select text, binary or delta output
+  void mode (plot_mode_t new_mode) {
+    plot_mode = new_mode;
+    schema_pending = true;
+  }
+
+  plot_mode_t mode (void) const { return plot_mode; }
+
+  // PLOT_DELTA sends whole values every n frames so a receiver that
+  // missed a packet recovers; 0 sends keys only with the schema
+  void keyframe_every (uint16_t n) {
+    key_every = n;
+  }
+
+  // send labelled text lines only when the series change (or every n
+  // frames), and bare comma separated values in between; in binary mode
+  // every_n also repeats the schema
+  void header_once (uint16_t every_n=0) {
+    _header_mode(true, every_n);
+  }
+
+  // label every text line (the default)
+  void header_always (void) {
+    _header_mode(false, 0);
+  }
+
+  // binary modes: send each frame's micros() at print(), as the change
+  // from the last frame sent (whole after a schema or key frame)
+  void timestamps (bool on=true) {
+    stamped = on;
+    schema_pending = true;
+  }
+
+  // resend the labels or binary schema with the next frame
+  void send_schema (void) { schema_pending = true; }
+
+  // send one frame for every n print() calls, reducing each series
+  // by its policy; 1 sends every frame
+  void decimate (uint16_t n) {
+    decimation = n ? n : 1;
+    frames_reduced = 0;
+    for (uint8_t i=0 ; i<SERIES ; i++) _reset_reducer(reducers[i]);
+  }
+
+  uint16_t decimate (void) const { return decimation; }
+
+  // how decimate() reduces all series, or the nth series added to a frame
+  void reduce (plot_reduce_t policy) {
+    for (uint8_t i=0 ; i<SERIES ; i++) reduce(i, policy);
+  }
+
+  void reduce (uint8_t series_index, plot_reduce_t policy) {
+    if (series_index >= SERIES) return;
+    reducers[series_index].policy = policy;
+    _reset_reducer(reducers[series_index]);
+  }
+
+ private:
+
+  struct PlotReducer {
+    float   a, b;     // sum, or max and min
+    uint8_t policy;
+    bool    show_min; // PLOT_MIN_MAX reports max and min in turn
+  };
+
+  void _header_mode (bool once, uint16_t every_n) {
+    labels_once = once;
+    header_every = every_n;
+    schema_pending = true;
+  }
+
+  void _reset_reducer (PlotReducer& r) {
+    r.a = (r.policy == PLOT_MIN_MAX) ? -3.4e38f : 0;
+    r.b = 3.4e38f;
+    r.show_min = false;
+  }
+
+  // fold one sample into its series' reducer
+  void _reduce (uint8_t i, const PlotValue& value) {
+    PlotReducer& r = reducers[i];
+    float v = value.as_float();
+    if (r.policy == PLOT_AVERAGE) {
+      r.a += v;
+    } else if (r.policy == PLOT_MIN_MAX) {
+      if (v > r.a) r.a = v;
+      if (v < r.b) r.b = v;
+    }
+  }
+
+  // true when this print() completes a decimation window, with the frame's
+  // values, reduced by each series' policy, in out
+  bool _window_done (const PlotValue* values, uint8_t count, PlotValue* out) {
+    for (uint8_t i=0 ; i<count ; i++) _reduce(i, values[i]);
+    if (++frames_reduced < decimation) return false;
+    frames_reduced = 0;
+    for (uint8_t i=0 ; i<count ; i++) {
+      PlotReducer& r = reducers[i];
+      out[i] = values[i];
+      float v;
+      if (r.policy == PLOT_AVERAGE) {
+        v = r.a / decimation;
+        r.a = 0;
+      } else if (r.policy == PLOT_MIN_MAX) {
+        // each extreme is held until it's reported, so no spike is lost
+        if (r.show_min) { v = r.b;  r.b =  3.4e38f; }
+        else            { v = r.a;  r.a = -3.4e38f; }
+        r.show_min = not r.show_min;
+      } else {
+        continue;
+      }
+      if (out[i].is_int()) out[i].i = int32_t(v < 0 ? v - 0.5f : v + 0.5f);
+      else                 out[i].f = v;
+    }
+    return true;
+  }
+
+  PlotReducer reducers[SERIES];
+  uint16_t decimation = 1;
+  uint16_t frames_reduced = 0;
+  plot_mode_t plot_mode = PLOT_TEXT;
+  uint8_t  schema_id = 0;
+  uint32_t schema_hash = 0;
+  bool     schema_pending = true;
+  bool     labels_once = false;
+  uint16_t header_every = 0;
+  uint16_t frames_since_header = 0;
+  int32_t  last_q[SERIES];                // PLOT_DELTA values last sent
+  uint16_t key_every = PLOT_KEYFRAME_INTERVAL;
+  uint16_t frames_since_key = 0;
+  uint8_t  delta_seq = 0;
+  bool     key_due = true;
+  bool     stamped = false;               // timestamps()
+  uint32_t last_stamp_us = 0;
+};
+
+/*
+ * PlotSink - another destination for each frame, with its own format,
+ * decimation and back-pressure policy. Register it with add_sink().
+ */
+template <uint8_t SERIES>
+class BasicPlotSink : public BasicPlotOutput<SERIES> {
+  template <size_t C, uint8_t S> friend class BasicPlot;
+
+ public:
+
+  BasicPlotSink (Stream& os, plot_mode_t format=PLOT_TEXT, plot_backpressure_t policy=PLOT_BLOCK)
+    : os(&os), backpressure(policy) {
+    this->mode(format);
+  }
+
+  // queued sinks never block; the queue drops frames that don't fit
+  BasicPlotSink (PlotQueue& queue, plot_mode_t format=PLOT_TEXT)
+    : queue(&queue) {
+    this->mode(format);
+  }
+
+  bool push (const uint8_t* frame, size_t n) {
+    if (queue) return queue->push(frame, n);
+    if (backpressure == PLOT_DROP and size_t(os->availableForWrite()) < n) {
+      dropped_frames++;
+      return false;
+    }
+    os->write(frame, n);
+    return true;
+  }
+
+  // frames dropped by PLOT_DROP (a queue counts its own)
+  unsigned long dropped (void) const { return dropped_frames; }
+
+ private:
+
+  Stream*    os = nullptr;
+  PlotQueue* queue = nullptr;
+  plot_backpressure_t backpressure = PLOT_BLOCK;
+  unsigned long dropped_frames = 0;
+  BasicPlotSink* next = nullptr;    // BasicPlot's list of sinks
+};
+
+typedef BasicPlotOutput<PLOT_MAX_SERIES> PlotOutput;
+typedef BasicPlotSink<PLOT_MAX_SERIES>   PlotSink;
+
+/*
+ * BasicPlot<CAPACITY, SERIES> - CAPACITY bytes of frame buffer, up to
+ * SERIES series per frame. Its sinks must be BasicPlotSink<SERIES>.
+ */
+template <size_t CAPACITY, uint8_t SERIES>
+class BasicPlot : public BasicPlotOutput<SERIES> {
+
+  typedef BasicPlotOutput<SERIES> PlotOutput;
+  typedef BasicPlotSink<SERIES>   PlotSink;
+
  public:
- 
-  void add(String label, float value, int offset, bool value_in_label=true) {
-    add(label, value, value_in_label, float(offset));
+
+  BasicPlot (void) {
+    precision(PLOT_DEFAULT_DECIMALS);
+    resolution(0);
+  }
+
+  template <typename T>
+  void add(PlotLabel label, T value, int offset, bool value_in_label=true) {
+    _add(label, plot_value(value), value_in_label, float(offset));
   } // needed for integer offset
 
-  void add(String label, float value, float offset, bool value_in_label=true) {
-    add(label, value, value_in_label, offset);
+  template <typename T>
+  void add(PlotLabel label, T value, float offset, bool value_in_label=true) {
+    _add(label, plot_value(value), value_in_label, offset);
   } // allows default value_in_label
 
-  void add(String label, float value, bool value_in_label=true, float offset=0) {
-    if (str.length()) str += String(",");
-    str += label;
-    if (value_in_label) str += (String("=") + value);
-    str += (String(":") + _constrain(value + offset));
+  template <typename T>
+  void add(PlotLabel label, T value, bool value_in_label=true, float offset=0) {
+    _add(label, plot_value(value), value_in_label, offset);
   } // allows default offset, then value_in_label
 
+  // send the frame to os and to every sink
   void print (Stream& os) {
-    os << str << endl;
-    str = "";
+    _StreamOut out = { os };
+    _print(out);
+  }
+
+  // queue the frame for PlotQueue::service() to send without blocking
+  void print (PlotQueue& queue) {
+    _print(queue);
+  }
+
+  // send the frame to the sinks only
+  void print (void) {
+    _begin_frame();
+    _fan_out();
+  }
+
+  // also send each frame to sink, encoded by its own settings
+  void add_sink (PlotSink& sink) {
+    remove_sink(sink);
+    sink.next = sinks;
+    sinks = &sink;
+  }
+
+  void remove_sink (PlotSink& sink) {
+    for (PlotSink** p = &sinks ; *p ; p = &(*p)->next) {
+      if (*p == &sink) {
+        *p = sink.next;
+        sink.next = nullptr;
+        return;
+      }
+    }
   }
 
   void constrain_off (void) {
@@ -77,16 +465,431 @@ class Plot {
     constrained = true;
   }
 
+  // set the number of decimal places for all series
+  void precision (uint8_t n_decimals) {
+    for (uint8_t i=0 ; i<SERIES ; i++) decimals[i] = n_decimals;
+  }
+
+  // set the number of decimal places for the nth series added to a frame
+  void precision (uint8_t series_index, uint8_t n_decimals) {
+    if (series_index < SERIES) decimals[series_index] = n_decimals;
+  }
+
+  // PLOT_DELTA step size for all series, or the nth series added to a
+  // frame; 0 (the default) is 1 for integers and 1 digit in the last
+  // precision() place for floats
+  void resolution (float step) {
+    for (uint8_t i=0 ; i<SERIES ; i++) resolutions[i] = step;
+  }
+
+  void resolution (uint8_t series_index, float step) {
+    if (series_index < SERIES) resolutions[series_index] = step;
+  }
+
+  // keep the output under percent of bytes_per_second (baud / 10 for a
+  // UART, or a measured rate for USB) by adjusting decimate() as the frame
+  // size and print() rate change; 0 turns throttling off
+  void throttle (uint32_t bytes_per_second, uint8_t percent=80) {
+    link_budget = bytes_per_second * (percent / 100.0f);
+    if (not link_budget) this->decimate(1);
+  }
+
+  // frames per second actually sent, and the bytes per second they take
+  float fps (void) const { return sent_us > 0 ? 1e6f / sent_us : 0; }
+  float bytes_per_second (void) const { return sent_bytes * fps(); }
+
+  // record frames into a PlotCapture instead of streaming them, and send
+  // the captured window once it triggers and fills
+  void capture (PlotCapture& capture) {
+    scope = &capture;
+  }
+
+  // stream every frame again
+  void capture_off (void) {
+    scope = nullptr;
+  }
+
+  // number of items or frames dropped because a buffer was full
+  unsigned long overflows (void) const { return overflow_count; }
+
  private:
 
+  struct PlotSeries {
+    float     offset;
+    uint16_t  label;          // index into labels[]
+    bool      value_in_label;
+  };
+
+  // true when the labels/schema must go out with this frame
+  bool _header_due (PlotOutput& o, const PlotValue* v) {
+    uint32_t hash = _schema_hash(o, v);
+    bool changed = o.schema_pending or hash != o.schema_hash;
+    if (changed) {
+      o.schema_hash = hash;
+      o.schema_id++;
+      o.schema_pending = false;
+    } else if (not o.header_every or ++o.frames_since_header < o.header_every) {
+      return false;
+    }
+    o.frames_since_header = 0;
+    return true;
+  }
+
   float _constrain (float val) {
     if (not constrained) return val;
     return constrain(val, constraint_min, constraint_max);
   }
 
-  String str;
-  bool constrained;
-  float constraint_max, constraint_min;
+  // record a series; the frame is encoded by print()
+  void _add (PlotLabel label, PlotValue value, bool value_in_label, float offset) {
+    size_t n = strlen(label.str) + 1;
+    if (count >= SERIES or labels_len + n > PLOT_LABEL_CAPACITY or n > 0xFF) {
+      overflow_count++;
+      return;
+    }
+    values[count] = value;
+    PlotSeries& s = series[count++];
+    s.offset = offset;
+    s.label = labels_len;
+    s.value_in_label = value_in_label;
+    memcpy(labels + labels_len, label.str, n);
+    labels_len += n;
+  }
+
+  // value + offset, on the integer path when nothing forces a float
+  PlotValue _graph (const PlotSeries& s, const PlotValue& value) {
+    PlotValue graph = value;
+    if (value.is_int() and not constrained and s.offset == int32_t(s.offset)) {
+      graph.i += int32_t(s.offset);
+    } else {
+      graph.type = PLOT_F32;
+      graph.f = _constrain(value.as_float() + s.offset);
+    }
+    return graph;
+  }
+
+  void _encode_text (const PlotValue* v, bool with_labels) {
+    len = 0;
+    for (uint8_t i=0 ; i<count ; i++) {
+      const PlotSeries& s = series[i];
+      size_t mark = len;
+      bool ok = (not len or _append(","))
+                and (not with_labels or _append_label(s, v[i], decimals[i]))
+                and _append(_graph(s, v[i]), decimals[i]);
+      if (not ok) {
+        len = mark;     // drop the whole item, never a partial one
+        overflow_count++;
+      }
+    }
+    buf[len++] = '\r';  // room reserved by _append()
+    buf[len++] = '\n';
+  }
+
+  // "label[=value]:"
+  bool _append_label (const PlotSeries& s, const PlotValue& value, uint8_t places) {
+    return _append(labels + s.label)
+           and (not s.value_in_label or (_append("=") and _append(value, places)))
+           and _append(":");
+  }
+
+  PLOT_NOINLINE bool _encode_schema (const PlotOutput& o, const PlotValue* v) {
+    uint8_t raw[CAPACITY];
+    size_t n = 0;
+    raw[n++] = PLOT_PKT_SCHEMA;
+    raw[n++] = o.schema_id;
+    raw[n++] = count;
+    raw[n++] = (constrained ? PLOT_FLG_CONSTRAINED : 0)
+             | (o.plot_mode == PLOT_DELTA ? PLOT_FLG_QUANTIZED : 0)
+             | (o.stamped ? PLOT_FLG_TIMESTAMP : 0);
+    plot_put_f32(raw + n, constraint_min);  n += 4;
+    plot_put_f32(raw + n, constraint_max);  n += 4;
+    for (uint8_t i=0 ; i<count ; i++) {
+      const PlotSeries& s = series[i];
+      const char* label = labels + s.label;
+      size_t label_len = strlen(label);
+      if (n + PLOT_SCHEMA_SERIES_LEN + label_len > CAPACITY) return _drop_frame();
+      raw[n++] = v[i].type | (s.value_in_label ? PLOT_FLG_VALUE_IN_LABEL : 0);
+      plot_put_f32(raw + n, s.offset);  n += 4;
+      raw[n++] = uint8_t(label_len);
+      memcpy(raw + n, label, label_len);
+      n += label_len;
+    }
+    if (o.plot_mode == PLOT_DELTA) {
+      if (n + 4 * count > CAPACITY) return _drop_frame();
+      for (uint8_t i=0 ; i<count ; i++, n += 4) plot_put_f32(raw + n, _resolution(i, v[i]));
+    }
+    return _cobs(raw, n);
+  }
+
+  PLOT_NOINLINE bool _encode_data (const PlotOutput& o, const PlotValue* v, bool absolute) {
+    uint8_t raw[CAPACITY];
+    size_t n = 0;
+    raw[n++] = PLOT_PKT_DATA;
+    raw[n++] = o.schema_id;
+    n += _encode_stamp(o, raw + n, absolute);
+    for (uint8_t i=0 ; i<count ; i++) {
+      if (n + 4 > CAPACITY) return _drop_frame();
+      n += plot_put_value(raw + n, v[i]);
+    }
+    return _cobs(raw, n);
+  }
+
+  // quantize this frame into q, and pack it whole or as the change since
+  // the last packet sent
+  PLOT_NOINLINE bool _encode_delta (const PlotOutput& o, const PlotValue* v, bool key, int32_t* q) {
+    uint8_t raw[CAPACITY];
+    size_t n = 0;
+    raw[n++] = key ? PLOT_PKT_KEY : PLOT_PKT_DELTA;
+    raw[n++] = o.schema_id;
+    raw[n++] = o.delta_seq;
+    n += _encode_stamp(o, raw + n, key);
+    for (uint8_t i=0 ; i<count ; i++) {
+      if (n + PLOT_VARINT_MAX > CAPACITY) return _drop_frame();
+      q[i] = plot_quantize(v[i], _resolution(i, v[i]));
+      uint32_t d = key ? uint32_t(q[i]) : uint32_t(q[i]) - uint32_t(o.last_q[i]);
+      n += plot_put_varint(raw + n, plot_zigzag(int32_t(d)));
+    }
+    return _cobs(raw, n);
+  }
+
+  // micros() at print(), whole or since the last frame sent
+  size_t _encode_stamp (const PlotOutput& o, uint8_t* p, bool absolute) {
+    if (not o.stamped) return 0;
+    return plot_put_varint(p, absolute ? frame_us : frame_us - o.last_stamp_us);
+  }
+
+  float _resolution (uint8_t i, const PlotValue& value) {
+    if (resolutions[i] > 0) return resolutions[i];
+    if (value.is_int()) return 1;
+    float step = 1;
+    for (uint8_t d=0 ; d<decimals[i] ; d++) step *= 0.1f;
+    return step;
+  }
+
+  bool _cobs (const uint8_t* raw, size_t n) {
+    len = plot_cobs_encode(raw, n, (uint8_t*)buf, CAPACITY);
+    return len or _drop_frame();
+  }
+
+  bool _drop_frame (void) {
+    len = 0;
+    overflow_count++;
+    return false;
+  }
+
+  // anything that changes the schema packet changes the hash; the part
+  // every output shares is worked out once per frame
+  uint32_t _schema_hash (const PlotOutput& o, const PlotValue* v) {
+    if (not frame_hashed) {
+      frame_hash = plot_hash(PLOT_FNV_SEED, labels, labels_len);
+      for (uint8_t i=0 ; i<count ; i++) {
+        frame_hash = plot_hash(frame_hash, &v[i].type, 1);
+        frame_hash = plot_hash(frame_hash, &series[i].value_in_label, 1);
+        frame_hash = plot_hash(frame_hash, &series[i].offset, 4);
+      }
+      frame_hash = plot_hash(frame_hash, &constrained, 1);
+      if (constrained) {
+        frame_hash = plot_hash(frame_hash, &constraint_min, 4);
+        frame_hash = plot_hash(frame_hash, &constraint_max, 4);
+      }
+      frame_hashed = true;
+    }
+    uint32_t hash = frame_hash;
+    if (o.plot_mode == PLOT_DELTA) {
+      for (uint8_t i=0 ; i<count ; i++) {
+        float step = _resolution(i, v[i]);
+        hash = plot_hash(hash, &step, 4);
+      }
+    }
+    return hash;
+  }
+
+  struct _StreamOut {
+    Stream& os;
+    bool push (const uint8_t* frame, size_t n) {
+      os.write(frame, n);
+      return true;
+    }
+  };
+
+  void _begin_frame (void) {
+    frame_us = micros();
+    frame_hashed = false;
+  }
+
+  // encode the frame and hand it to out, then to the sinks
+  template <typename Out>
+  void _print (Out& out) {
+    _begin_frame();
+    uint32_t now = frame_us;
+    _smooth(source_us, now - last_print_us, prints);
+    last_print_us = now;
+    if (scope) {
+      _capture(out);
+    } else if (_output(out, *this)) {
+      _smooth(sent_us, now - last_sent_us, frames_sent);
+      _smooth(sent_bytes, frame_bytes, frames_sent);
+      last_sent_us = now;
+      frames_sent++;
+      if (link_budget) _throttle();
+    }
+    _fan_out();
+  }
+
+  // every sink gets the frame by its own settings, then the next frame starts
+  void _fan_out (void) {
+    for (PlotSink* sink = sinks ; sink ; sink = sink->next) _output(*sink, *sink);
+    prints++;
+    count = 0;
+    labels_len = 0;
+  }
+
+  // send the frame if it completes o's decimation window; true if it did
+  template <typename Out>
+  bool _output (Out& out, PlotOutput& o) {
+    if (o.decimation <= 1) {
+      _send(out, o, values);
+      return true;
+    }
+    PlotValue reduced[SERIES];
+    if (not o._window_done(values, count, reduced)) return false;
+    _send(out, o, reduced);
+    return true;
+  }
+
+  // encode v by o's settings and push it; a header that out drops is
+  // resent with the next frame so values never go out unlabelled.
+  // Returns true if the values went out.
+  template <typename Out>
+  bool _send (Out& out, PlotOutput& o, const PlotValue* v) {
+    frame_bytes = 0;
+    bool ok;
+    if (o.plot_mode != PLOT_TEXT) {
+      ok = true;
+      if (_header_due(o, v)) {
+        ok = _encode_schema(o, v) and _push(out);
+        o.key_due = true;   // deltas and timestamps need a reference under the new schema
+      }
+      if (not ok) o.schema_pending = true;
+      if (o.plot_mode == PLOT_DELTA) {
+        int32_t q[SERIES];
+        bool key = o.key_due or (o.key_every and o.frames_since_key + 1 >= o.key_every);
+        ok = ok and _encode_delta(o, v, key, q) and _push(out);
+        if (ok) {   // only what the receiver got is a reference
+          memcpy(o.last_q, q, count * sizeof(q[0]));
+          o.delta_seq++;
+          o.frames_since_key = key ? 0 : o.frames_since_key + 1;
+          o.key_due = false;
+        }
+      } else {
+        ok = ok and _encode_data(o, v, o.key_due) and _push(out);
+        if (ok) o.key_due = false;
+      }
+      if (ok) o.last_stamp_us = frame_us;
+    } else {
+      bool with_labels = not o.labels_once or _header_due(o, v);
+      _encode_text(v, with_labels);
+      ok = _push(out);
+      if (not ok and with_labels) o.schema_pending = true;
+    }
+    return ok;
+  }
+
+  // record the frame into the capture, then send what it holds, oldest
+  // first, until out is full; the rest goes with the next print()
+  template <typename Out>
+  void _capture (Out& out) {
+    if (scope->state() <= PlotCapture::TRIGGERED) {
+      scope->record(values, count, _find(scope->trigger_series()));
+    }
+    PlotValue held[SERIES];
+    memcpy(held, values, count * sizeof(held[0]));
+    uint8_t n = (count < scope->series_count()) ? count : scope->series_count();
+    const PlotValue* frame;
+    while ((frame = scope->next()) != nullptr) {
+      memcpy(held, frame, n * sizeof(held[0]));
+      if (not _send(out, *this, held)) break;
+      scope->sent();
+    }
+  }
+
+  // position of a label in this frame, or -1
+  int _find (const char* label) {
+    if (not label) return -1;
+    for (uint8_t i=0 ; i<count ; i++) {
+      if (strcmp(labels + series[i].label, label) == 0) return i;
+    }
+    return -1;
+  }
+
+  template <typename Out>
+  bool _push (Out& out) {
+    bool ok = out.push((const uint8_t*)buf, len);
+    if (ok) frame_bytes += len;
+    return ok;
+  }
+
+  // EMA with k = 1/16, seeded by the second sample (the first has no interval)
+  static void _smooth (float& ema, float sample, unsigned long n) {
+    if (n == 1) ema = sample;
+    else if (n > 1) ema += (sample - ema) * 0.0625f;
+  }
+
+  // pick the smallest decimation that keeps the output within budget
+  void _throttle (void) {
+    if (source_us <= 0 or prints < 2) return;
+    float demand = sent_bytes * 1e6f / source_us;  // bytes/s sending every frame
+    float need = demand / link_budget;
+    uint16_t d = this->decimation;
+    if (need > d) {
+      d = (need < PLOT_MAX_DECIMATION) ? uint16_t(need) + 1 : PLOT_MAX_DECIMATION;
+    } else if (d > 1 and need < (d - 1) * 0.9f) {  // hysteresis on the way down
+      d = uint16_t(need) + 1;
+    }
+    this->decimation = d;
+  }
+
+  bool _append (const char* s) {
+    size_t n = strlen(s);
+    if (len + n + 2 >= CAPACITY) return false;  // keep room for "\r\n"
+    memcpy(buf + len, s, n);
+    len += n;
+    return true;
+  }
+
+  bool _append (const PlotValue& value, uint8_t places) {
+    if (len + 3 >= CAPACITY) return false;
+    size_t n = plot_format_value(buf + len, CAPACITY - len - 2, value, places);
+    len += n;
+    return n;
+  }
+
+  char   buf[CAPACITY];               // the encoded frame, for one output at a time
+  size_t len = 0;
+  PlotValue  values[SERIES];          // this frame's values
+  PlotSeries series[SERIES];          // ... and how to show them
+  uint8_t count = 0;
+  char   labels[PLOT_LABEL_CAPACITY]; // this frame's labels
+  size_t labels_len = 0;
+  uint8_t decimals[SERIES];           // per-series precision
+  float   resolutions[SERIES];        // PLOT_DELTA steps, 0 = auto
+  float    link_budget = 0;         // bytes/s throttle() aims for
+  float    source_us = 0;           // EMA of the time between print() calls
+  float    sent_us = 0;             // ... and between frames sent
+  float    sent_bytes = 0;          // ... and of bytes per frame sent
+  size_t   frame_bytes = 0;
+  uint32_t last_print_us = 0, last_sent_us = 0;
+  unsigned long prints = 0, frames_sent = 0;
+  uint32_t frame_us = 0;            // micros() at print()
+  uint32_t frame_hash = 0;          // _schema_hash()'s shared part
+  bool     frame_hashed = false;
+  PlotSink* sinks = nullptr;
+  PlotCapture* scope = nullptr;
+  unsigned long overflow_count = 0;
+  bool constrained = false;
+  float constraint_max = 0, constraint_min = 0;
 };
 
+typedef BasicPlot<PLOT_CAPACITY> Plot;
+
 #endif /* _H */
@@ -0,0 +1,159 @@
+#ifndef PLOT_CAPTURE_H
+#define PLOT_CAPTURE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "pPlotFormat.h"
+
+/*****************************************************************************
+ * PlotCapture - oscilloscope style triggered capture for Plot.
+ *
+ * While a capture is attached, print() stops streaming. Each frame's raw
+ * values go into a ring buffer instead, and the buffer is checked for a
+ * trigger: the named series crossing a level, or a call to trigger().
+ * After the trigger the capture records the post-trigger frames, then
+ * print() sends the whole window - pre-trigger frames, the trigger frame
+ * and post-trigger frames - at full resolution and goes quiet until arm().
+ *
+ * A captured frame is only released once it has been accepted by the
+ * stream or PlotQueue, so nothing is lost to back-pressure.
+ *
+ * Usage:
+ *  PlotValue scope_buf[64 * 3];          // 64 frames of 3 series
+ *  PlotCapture scope(scope_buf, 3, 16);  // 16 frames kept before the trigger
+ *
+ *  scope.trigger_on("z", 20, PLOT_RISING);
+ *  plot.capture(scope);                  // plot.capture_off() to stream again
+ *  ...
+ *  if (scope.done()) scope.arm();        // after it's been sent, capture again
+ *
+ * Labels, offsets and types come from the frame being printed while the
+ * capture is sent, so keep the series the same during a capture.
+ *****************************************************************************/
+
+enum plot_edge_t {
+  PLOT_RISING,
+  PLOT_FALLING,
+  PLOT_EITHER
+};
+
+class PlotCapture {
+ public:
+
+  enum state_t {
+    ARMED,      // recording pre-trigger frames, watching for the trigger
+    TRIGGERED,  // recording post-trigger frames
+    HOLDING,    // full, being sent
+    DONE        // sent, quiet until arm()
+  };
+
+  template <size_t N>
+  PlotCapture (PlotValue (&storage)[N], uint8_t n_series, uint16_t pre_trigger_frames)
+    : frames(storage), series(n_series), capacity(N / n_series),
+      pre(pre_trigger_frames < N / n_series ? pre_trigger_frames : N / n_series) {
+    arm();
+  }
+
+  // trigger when the labelled series crosses level
+  void trigger_on (const char* label, float level, plot_edge_t edge=PLOT_RISING) {
+    trigger_label = label;
+    trigger_level = level;
+    trigger_edge = edge;
+    have_last = false;
+  }
+
+  // trigger now, e.g., from a button or an event in the sketch
+  void trigger (void) {
+    manual = true;
+  }
+
+  // clear the buffer and wait for the next trigger
+  void arm (void) {
+    head = stored = post_left = sent_count = 0;
+    manual = have_last = false;
+    capture_state = ARMED;
+  }
+
+  state_t state (void) const { return capture_state; }
+  bool done (void) const { return capture_state == DONE; }
+
+  /*
+   * called by Plot
+   */
+
+  const char* trigger_series (void) const { return trigger_label; }
+
+  // store one frame; trigger_index is the trigger series' position or -1
+  void record (const PlotValue* values, uint8_t n, int trigger_index) {
+    if (capture_state != ARMED and capture_state != TRIGGERED) return;
+    PlotValue* frame = frames + head * series;
+    for (uint8_t i=0 ; i<series ; i++) {
+      if (i < n) {
+        frame[i] = values[i];
+      } else {
+        frame[i].type = PLOT_I16;
+        frame[i].i = 0;
+      }
+    }
+    if (++head == capacity) head = 0;
+    if (stored < capacity) stored++;
+
+    if (capture_state == ARMED) {
+      if (manual or (trigger_index >= 0 and trigger_index < n and _crossed(values[trigger_index].as_float()))) {
+        capture_state = TRIGGERED;
+        post_left = capacity - pre;
+      }
+    } else if (post_left) {
+      post_left--;
+    }
+    if (capture_state == TRIGGERED and not post_left) {
+      capture_state = HOLDING;
+      sent_count = 0;
+    }
+  }
+
+  // the oldest frame not yet sent, or nullptr when there's nothing to send
+  const PlotValue* next (void) const {
+    if (capture_state != HOLDING) return nullptr;
+    size_t i = head + capacity - stored + sent_count;
+    if (i >= capacity) i -= capacity;
+    return frames + i * series;
+  }
+
+  // the frame from next() was accepted
+  void sent (void) {
+    if (capture_state == HOLDING and ++sent_count >= stored) capture_state = DONE;
+  }
+
+  uint8_t series_count (void) const { return series; }
+
+ private:
+
+  bool _crossed (float sample) {
+    bool crossed = false;
+    if (have_last) {
+      bool up   = last_sample <  trigger_level and sample >= trigger_level;
+      bool down = last_sample >= trigger_level and sample <  trigger_level;
+      crossed = (trigger_edge == PLOT_RISING)  ? up
+              : (trigger_edge == PLOT_FALLING) ? down : (up or down);
+    }
+    last_sample = sample;
+    have_last = true;
+    return crossed;
+  }
+
+  PlotValue* frames;
+  uint8_t    series;
+  size_t     capacity;      // frames
+  size_t     pre;           // frames kept up to and including the trigger
+  size_t     head, stored, post_left, sent_count;
+  state_t    capture_state;
+  const char* trigger_label = nullptr;
+  float       trigger_level = 0;
+  plot_edge_t trigger_edge = PLOT_RISING;
+  float       last_sample = 0;
+  bool        have_last, manual;
+};
+
+#endif /* _H */
@@ -0,0 +1,210 @@
+#ifndef PLOT_CODEC_H
+#define PLOT_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "pPlotFormat.h"
+
+/*****************************************************************************
+ * pPlotCodec - packet layout and COBS framing for Plot's binary mode.
+ *
+ * Every packet is COBS encoded and terminated with a 0x00 byte, so a
+ * receiver can always resynchronize at the next zero. Multi-byte fields
+ * are little-endian.
+ *
+ * Schema packet - sent on the first frame and whenever the series change:
+ *   [PLOT_PKT_SCHEMA][schema id][count][flags][min f32][max f32]
+ *   count x [type | PLOT_FLG_VALUE_IN_LABEL][offset f32][label len][label]
+ *
+ * Data packet - one per print():
+ *   [PLOT_PKT_DATA][schema id] count x value (f32, i16, u16 or i32)
+ *
+ * The graph value is value + offset, clipped to [min,max] when the
+ * PLOT_FLG_CONSTRAINED schema flag is set, exactly as in text mode.
+ *
+ * Delta mode - the schema has PLOT_FLG_QUANTIZED set and ends with
+ *   count x [resolution f32]
+ * and each value is sent as q = round(value / resolution), an int32. A
+ * key packet carries the q values, and delta packets carry the change
+ * from the previous packet, both as zigzag varints (1 byte for -64..63):
+ *   [PLOT_PKT_KEY][schema id][seq] count x varint(zigzag(q))
+ *   [PLOT_PKT_DELTA][schema id][seq] count x varint(zigzag(q - q_prev))
+ * seq counts packets mod 256; after a gap the receiver waits for a key.
+ * Deltas wrap mod 2^32, so decoding is exact for any q.
+ *
+ * Timestamps - with PLOT_FLG_TIMESTAMP in the schema flags, data, key and
+ * delta packets have a varint micros() stamp right after the header bytes
+ * (schema id, or seq):
+ *   [PLOT_PKT_DATA][schema id][varint stamp] values...
+ * The stamp is the whole 32-bit micros() in the first data packet after
+ * a schema and in key packets, and the microseconds since the previous
+ * packet otherwise.
+ *
+ * This header has no Arduino dependencies so host tools can share it.
+ *****************************************************************************/
+
+#define PLOT_PKT_SCHEMA  0x01
+#define PLOT_PKT_DATA    0x02
+#define PLOT_PKT_KEY     0x03
+#define PLOT_PKT_DELTA   0x04
+
+#define PLOT_FLG_CONSTRAINED     0x01  // schema flags
+#define PLOT_FLG_QUANTIZED       0x02
+#define PLOT_FLG_TIMESTAMP       0x04
+#define PLOT_FLG_VALUE_IN_LABEL  0x80  // series type byte
+#define PLOT_TYPE_MASK           0x0F
+
+#define PLOT_SCHEMA_HEADER_LEN  12
+#define PLOT_SCHEMA_SERIES_LEN   6     // plus the label
+
+#define PLOT_VARINT_MAX  5     // bytes for a 32-bit varint
+
+// COBS adds one byte per 254 plus the 0x00 delimiter
+#define PLOT_COBS_OVERHEAD(n)  ((n) / 254 + 2)
+
+inline size_t plot_type_size (uint8_t type) {
+  return ((type & PLOT_TYPE_MASK) == PLOT_I16 or (type & PLOT_TYPE_MASK) == PLOT_U16) ? 2 : 4;
+}
+
+inline void plot_put_u32 (uint8_t* p, uint32_t v) {
+  p[0] = uint8_t(v);
+  p[1] = uint8_t(v >> 8);
+  p[2] = uint8_t(v >> 16);
+  p[3] = uint8_t(v >> 24);
+}
+
+inline uint32_t plot_get_u32 (const uint8_t* p) {
+  return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+inline void plot_put_f32 (uint8_t* p, float f) {
+  uint32_t bits;
+  memcpy(&bits, &f, 4);
+  plot_put_u32(p, bits);
+}
+
+inline float plot_get_f32 (const uint8_t* p) {
+  uint32_t bits = plot_get_u32(p);
+  float f;
+  memcpy(&f, &bits, 4);
+  return f;
+}
+
+// pack a value at its type's width, returns bytes written
+inline size_t plot_put_value (uint8_t* p, const PlotValue& v) {
+  if (v.type == PLOT_F32) {
+    plot_put_f32(p, v.f);
+    return 4;
+  }
+  if (v.type == PLOT_I32) {
+    plot_put_u32(p, uint32_t(v.i));
+    return 4;
+  }
+  p[0] = uint8_t(v.i);
+  p[1] = uint8_t(v.i >> 8);
+  return 2;
+}
+
+inline size_t plot_get_value (const uint8_t* p, uint8_t type, PlotValue& v) {
+  v.type = type & PLOT_TYPE_MASK;
+  switch (v.type) {
+    case PLOT_F32: v.f = plot_get_f32(p);                          return 4;
+    case PLOT_I32: v.i = int32_t(plot_get_u32(p));                 return 4;
+    case PLOT_I16: v.i = int16_t(uint16_t(p[0] | (p[1] << 8)));    return 2;
+    default:       v.i = uint16_t(p[0] | (p[1] << 8));             return 2;
+  }
+}
+
+// map signed to unsigned so small magnitudes of either sign stay small
+inline uint32_t plot_zigzag (int32_t v) {
+  return (uint32_t(v) << 1) ^ uint32_t(v >> 31);
+}
+
+inline int32_t plot_unzigzag (uint32_t u) {
+  return int32_t(u >> 1) ^ -int32_t(u & 1);
+}
+
+// 7 bits per byte, low first, high bit set on all but the last
+inline size_t plot_put_varint (uint8_t* p, uint32_t u) {
+  size_t n = 0;
+  while (u >= 0x80) {
+    p[n++] = uint8_t(u) | 0x80;
+    u >>= 7;
+  }
+  p[n++] = uint8_t(u);
+  return n;
+}
+
+// returns bytes read, or 0 if the varint runs past len
+inline size_t plot_get_varint (const uint8_t* p, size_t len, uint32_t& u) {
+  u = 0;
+  for (size_t n=0 ; n<len and n<PLOT_VARINT_MAX ; n++) {
+    u |= uint32_t(p[n] & 0x7F) << (7 * n);
+    if (not (p[n] & 0x80)) return n + 1;
+  }
+  return 0;
+}
+
+// value in resolution steps, rounded and clamped to int32
+inline int32_t plot_quantize (const PlotValue& v, float resolution) {
+  if (v.is_int() and resolution == 1.0f) return v.i;
+  float q = v.as_float() / resolution;
+  if (q != q) return 0;
+  if (q >=  2147483520.0f) return  2147483647;
+  if (q <= -2147483520.0f) return -2147483647 - 1;
+  return int32_t(q < 0 ? q - 0.5f : q + 0.5f);
+}
+
+// 32-bit FNV-1a, used to notice when the series set changes
+#define PLOT_FNV_SEED  2166136261ul
+
+inline uint32_t plot_hash (uint32_t hash, const void* data, size_t len) {
+  const uint8_t* p = (const uint8_t*)data;
+  while (len--) {
+    hash ^= *p++;
+    hash *= 16777619ul;
+  }
+  return hash;
+}
+
+/*
+ * COBS encode len bytes of src into dst, including the trailing 0x00.
+ * Returns the encoded length, or 0 if it won't fit in size bytes.
+ */
+inline size_t plot_cobs_encode (const uint8_t* src, size_t len, uint8_t* dst, size_t size) {
+  if (len + PLOT_COBS_OVERHEAD(len) > size) return 0;
+  size_t out = 1, code_pos = 0;
+  uint8_t code = 1;
+  for (size_t i=0 ; i<len ; i++) {
+    if (src[i]) {
+      dst[out++] = src[i];
+      code++;
+    }
+    if (not src[i] or code == 0xFF) {
+      dst[code_pos] = code;
+      code_pos = out++;
+      code = 1;
+    }
+  }
+  dst[code_pos] = code;
+  dst[out++] = 0x00;
+  return out;
+}
+
+/*
+ * COBS decode len bytes of src (without the 0x00 delimiter) into dst.
+ * Returns the decoded length, or 0 for a malformed packet.
+ */
+inline size_t plot_cobs_decode (const uint8_t* src, size_t len, uint8_t* dst) {
+  size_t in = 0, out = 0;
+  while (in < len) {
+    uint8_t code = src[in++];
+    if (code == 0 or in + code - 1 > len) return 0;
+    for (uint8_t i=1 ; i<code ; i++) dst[out++] = src[in++];
+    if (code != 0xFF and in < len) dst[out++] = 0x00;
+  }
+  return out;
+}
+
+#endif /* _H */
@@ -0,0 +1,161 @@
+#ifndef PLOT_FORMAT_H
+#define PLOT_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*****************************************************************************
+ * pPlotFormat - allocation-free number formatting for Plot.
+ *
+ * Floats are scaled by 10^decimals, rounded to a 32-bit integer and written
+ * out digit by digit, so there is no dtostrf()/printf() and no heap. Digits
+ * are peeled off with a shift-and-add divide by ten because Cortex-M0+ and
+ * AVR parts have no hardware divider.
+ *
+ * Each function writes a terminated string into buf and returns its length,
+ * or 0 (with buf untouched) if it won't fit in size bytes.
+ *
+ * plot_format_int(buf, size, value)             - "-1234"
+ * plot_format_float(buf, size, value, decimals) - "-12.34"
+ *
+ * Special values follow Print::print(float): "nan", "inf", and "ovf" for
+ * magnitudes beyond 32 bits. Precision is reduced when a large value would
+ * overflow the scaled integer.
+ *
+ * This header has no Arduino dependencies so host tools can share it.
+ *****************************************************************************/
+
+#define PLOT_MAX_DECIMALS      6
+#define PLOT_DEFAULT_DECIMALS  2   // same as String(float) and Print
+
+#define PLOT_UINT32_LIMIT  4294967040.0f  // largest float below 2^32
+
+// n / 10 without a divide instruction, remainder in rem (Hacker's Delight)
+inline uint32_t plot_divu10 (uint32_t n, uint8_t& rem) {
+  uint32_t q = (n >> 1) + (n >> 2);
+  q += q >> 4;
+  q += q >> 8;
+  q += q >> 16;
+  q >>= 3;
+  uint32_t r = n - ((q << 3) + (q << 1));  // n - q*10
+  if (r > 9) { q++; r -= 10; }
+  rem = uint8_t(r);
+  return q;
+}
+
+inline size_t plot_format_str (char* buf, size_t size, const char* s) {
+  size_t n = 0;
+  while (s[n]) n++;
+  if (n >= size) return 0;
+  for (size_t i=0 ; i<=n ; i++) buf[i] = s[i];
+  return n;
+}
+
+// write magnitude mag with the decimal point placed decimals digits from the right
+inline size_t plot_format_scaled (char* buf, size_t size, uint32_t mag, bool neg, uint8_t decimals) {
+  char digits[12];
+  uint8_t n = 0, d;
+  do {
+    mag = plot_divu10(mag, d);
+    digits[n++] = char('0' + d);
+  } while (mag or n <= decimals);  // at least one digit before the point
+  size_t len = neg + n + (decimals ? 1 : 0);
+  if (len >= size) return 0;
+  char* p = buf;
+  if (neg) *p++ = '-';
+  while (n) {
+    if (n == decimals) *p++ = '.';
+    *p++ = digits[--n];
+  }
+  *p = '\0';
+  return len;
+}
+
+inline size_t plot_format_int (char* buf, size_t size, int32_t value) {
+  bool neg = (value < 0);
+  uint32_t mag = neg ? 0u - uint32_t(value) : uint32_t(value);
+  return plot_format_scaled(buf, size, mag, neg, 0);
+}
+
+inline size_t plot_format_float (char* buf, size_t size, float value, uint8_t decimals=PLOT_DEFAULT_DECIMALS) {
+  static const float scale[PLOT_MAX_DECIMALS+1] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f };
+  if (value != value) return plot_format_str(buf, size, "nan");
+  bool neg = (value < 0);
+  if (neg) value = -value;
+  if (value > 3.4028235e38f) return plot_format_str(buf, size, "inf");
+  if (value > PLOT_UINT32_LIMIT) return plot_format_str(buf, size, "ovf");
+  if (decimals > PLOT_MAX_DECIMALS) decimals = PLOT_MAX_DECIMALS;
+  float scaled = value * scale[decimals] + 0.5f;
+  while (decimals and scaled >= PLOT_UINT32_LIMIT) {  // trade precision for range
+    scaled = value * scale[--decimals] + 0.5f;
+  }
+  uint32_t mag = uint32_t(scaled);
+  return plot_format_scaled(buf, size, mag, neg and mag, decimals);
+}
+
+/*
+ * PlotValue - a plotted number, kept as an integer when the caller passed
+ * one that fits in 32 bits so it can skip the float path entirely. The
+ * type code also sets the field width used by binary output.
+ */
+
+enum plot_type_t {
+  PLOT_F32,   // float
+  PLOT_I16,   // char, short, int on AVR
+  PLOT_U16,   // unsigned short, unsigned int on AVR
+  PLOT_I32    // long, int on 32-bit cores
+};
+
+struct PlotValue {
+  uint8_t type;
+  union {
+    int32_t i;
+    float   f;
+  };
+  bool is_int (void) const { return type != PLOT_F32; }
+  float as_float (void) const { return is_int() ? float(i) : f; }
+};
+
+// which add() argument types take the integer path, and at what width
+template <typename T> struct plot_int_traits {
+  static const uint8_t type = PLOT_F32;
+  static bool fits (T) { return false; }
+};
+
+#define PLOT_INT_TRAITS(T, test) \
+  template <> struct plot_int_traits<T> { \
+    static const uint8_t type = (sizeof(T) > 2) ? PLOT_I32 \
+                              : ((T)-1 < (T)0) ? PLOT_I16 : PLOT_U16; \
+    static bool fits (T v) { (void)v; return (test); } \
+  }
+
+PLOT_INT_TRAITS(bool,           true);
+PLOT_INT_TRAITS(char,           true);
+PLOT_INT_TRAITS(signed char,    true);
+PLOT_INT_TRAITS(unsigned char,  true);
+PLOT_INT_TRAITS(short,          true);
+PLOT_INT_TRAITS(unsigned short, true);
+PLOT_INT_TRAITS(int,            true);
+PLOT_INT_TRAITS(unsigned int,   v <= 0x7FFFFFFFu);
+PLOT_INT_TRAITS(long,           v >= -0x7FFFFFFFL - 1 and v <= 0x7FFFFFFFL);
+PLOT_INT_TRAITS(unsigned long,  v <= 0x7FFFFFFFul);
+
+template <typename T>
+inline PlotValue plot_value (T v) {
+  PlotValue pv;
+  if (plot_int_traits<T>::fits(v)) {
+    pv.type = plot_int_traits<T>::type;
+    pv.i = int32_t(v);
+  } else {
+    pv.type = PLOT_F32;
+    pv.f = float(v);
+  }
+  return pv;
+}
+
+inline size_t plot_format_value (char* buf, size_t size, const PlotValue& v, uint8_t decimals) {
+  return v.is_int() ? plot_format_int(buf, size, v.i)
+                    : plot_format_float(buf, size, v.f, decimals);
+}
+
+#endif /* _H */
@@ -0,0 +1,139 @@
+#ifndef PLOT_FRAME_H
+#define PLOT_FRAME_H
+
+#include <Arduino.h>
+#include "pPlotFormat.h"
+#include "pPlotQueue.h"
+
+/*****************************************************************************
+ * PlotFrame - a plot line whose layout is fixed at compile time.
+ *
+ * When the series and their labels never change, the label text, offsets,
+ * value_in_label choice, precision and constraints can all be template
+ * arguments. The "label=" and ":" text is merged into string literals by the
+ * compiler, the buffer is sized for the longest possible line so there are
+ * no bounds checks, and print() only formats the numbers. Passing the wrong
+ * number of values is a compile error.
+ *
+ * Usage:
+ *  PLOT_LABEL(AX, "ax");                  // one label type per series
+ *  PLOT_LABEL(AY, "ay");
+ *  PLOT_LABEL(TOUCH, "touch");
+ *
+ *  PlotFrame< PlotField<AX, 5>,           // ax around +5
+ *             PlotField<AY, -5>,          // ay around -5
+ *             PlotField<TOUCH, 0, false>  // no value in the label
+ *           > imu_frame;
+ *
+ *  imu_frame.print(Serial, ax, ay, touched);   // or print(plot_queue, ...)
+ *
+ * PlotField<Label, Offset=0, ValueInLabel=true, Decimals=2, Min, Max>
+ *  Offset, Min and Max are integers. Leave Min/Max off for no clipping.
+ *
+ * Values are formatted as in Plot: integers on the integer path, floats
+ * with Decimals places.
+ *****************************************************************************/
+
+#define PLOT_NO_MIN  (-0x7FFFFFFFL - 1)
+#define PLOT_NO_MAX  0x7FFFFFFFL
+
+#define PLOT_NUMBER_LEN(decimals)  (11 + 1 + (decimals))  // "-4294967040" "." decimals
+
+// declare a label type for PlotField
+#define PLOT_LABEL(name, text) \
+  struct name { \
+    static const size_t len = sizeof(text) - 1; \
+    static const char* with_value (void) { return text "="; } \
+    static const char* bare (void)       { return text ":"; } \
+  }
+
+template <typename Label, long Offset=0, bool ValueInLabel=true,
+          uint8_t Decimals=PLOT_DEFAULT_DECIMALS,
+          long Min=PLOT_NO_MIN, long Max=PLOT_NO_MAX>
+struct PlotField {
+  static const size_t number_len = PLOT_NUMBER_LEN(Decimals);
+  static const bool   clipped = (Min != PLOT_NO_MIN or Max != PLOT_NO_MAX);
+
+  // ",label=value:graph" at its longest
+  static const size_t max_len = 1 + Label::len + 1 + number_len
+                              + (ValueInLabel ? 1 + number_len : 0);
+
+  template <bool First, typename T>
+  static char* emit (char* p, T v) {
+    PlotValue value = plot_value(v);
+    if (not First) *p++ = ',';
+    if (ValueInLabel) {
+      memcpy(p, Label::with_value(), Label::len + 1);
+      p += Label::len + 1;
+      p += plot_format_value(p, number_len + 1, value, Decimals);
+      *p++ = ':';
+    } else {
+      memcpy(p, Label::bare(), Label::len + 1);
+      p += Label::len + 1;
+    }
+    if (value.is_int() and not clipped) {
+      value.i += Offset;
+    } else {
+      float graph = value.as_float() + Offset;
+      if (clipped) graph = constrain(graph, float(Min), float(Max));
+      value.type = PLOT_F32;
+      value.f = graph;
+    }
+    return p + plot_format_value(p, number_len + 1, value, Decimals);
+  }
+};
+
+// walks the field and value packs together
+template <bool First, typename... Fields> struct PlotFieldList;
+
+template <bool First>
+struct PlotFieldList<First> {
+  static const size_t max_len = 0;
+  static char* emit (char* p) { return p; }
+};
+
+template <bool First, typename Field, typename... Rest>
+struct PlotFieldList<First, Field, Rest...> {
+  static const size_t max_len = Field::max_len + PlotFieldList<false, Rest...>::max_len;
+
+  template <typename T, typename... Ts>
+  static char* emit (char* p, T value, Ts... values) {
+    p = Field::template emit<First>(p, value);
+    return PlotFieldList<false, Rest...>::emit(p, values...);
+  }
+};
+
+template <typename... Fields>
+class PlotFrame {
+  typedef PlotFieldList<true, Fields...> List;
+
+ public:
+
+  static const size_t max_length = List::max_len + 2;  // with "\r\n"
+
+  template <typename... Values>
+  void print (Stream& os, Values... values) {
+    os.write((const uint8_t*)buf, _format(values...));
+  }
+
+  template <typename... Values>
+  bool print (PlotQueue& queue, Values... values) {
+    return queue.push((const uint8_t*)buf, _format(values...));
+  }
+
+ private:
+
+  template <typename... Values>
+  size_t _format (Values... values) {
+    static_assert(sizeof...(Values) == sizeof...(Fields),
+                  "PlotFrame::print() needs one value per PlotField");
+    char* p = List::emit(buf, values...);
+    *p++ = '\r';
+    *p++ = '\n';
+    return p - buf;
+  }
+
+  char buf[max_length + 1];  // room for the formatter's terminator
+};
+
+#endif /* _H */
@@ -0,0 +1,107 @@
+#ifndef PLOT_QUEUE_H
+#define PLOT_QUEUE_H
+
+#include <Arduino.h>
+
+/*****************************************************************************
+ * PlotQueue - non-blocking output for Plot.
+ *
+ * print(queue) puts whole frames into a ring buffer instead of writing them,
+ * and service() drains only what the stream says it can take without
+ * blocking. A frame that doesn't fit is dropped whole, so a line is never
+ * cut short when the link falls behind.
+ *
+ * Usage:
+ *  uint8_t plot_ring[512];                 // you provide the storage
+ *  PlotQueue plot_queue(Serial, plot_ring);
+ *
+ *  plot.print(plot_queue);   // queue the frame, never blocks
+ *  plot_queue.service();     // call every loop()
+ *
+ * The stream must implement availableForWrite() - HardwareSerial and the
+ * SAMD/RP2040 USB Serial do, but the Print default always returns 0.
+ *
+ * Each frame is stored with a 2 byte length so service() can count frames
+ * as they finish; the length is not sent.
+ *****************************************************************************/
+
+#define PLOT_QUEUE_FRAME_HDR  2
+
+class PlotQueue {
+ public:
+
+  template <size_t N>
+  PlotQueue (Stream& os, uint8_t (&storage)[N])
+    : os(os), ring(storage), size(N) {}
+
+  // queue one whole frame, returns false (and counts a drop) if it won't fit
+  bool push (const uint8_t* frame, size_t n) {
+    if (n == 0) return true;
+    if (n > 0xFFFF or used + PLOT_QUEUE_FRAME_HDR + n > size) {
+      dropped_frames++;
+      return false;
+    }
+    uint8_t hdr[PLOT_QUEUE_FRAME_HDR] = { uint8_t(n), uint8_t(n >> 8) };
+    _put(hdr, PLOT_QUEUE_FRAME_HDR);
+    _put(frame, n);
+    return true;
+  }
+
+  // write as much as the stream will take without blocking
+  void service (void) {
+    int room = os.availableForWrite();
+    while (room > 0 and used) {
+      if (not frame_left) {
+        frame_left  = _take();
+        frame_left |= size_t(_take()) << 8;
+      }
+      size_t n = frame_left;
+      if (n > size_t(room))  n = room;
+      if (n > size - tail)   n = size - tail;  // up to the end of the ring
+      os.write(ring + tail, n);
+      tail += n;
+      if (tail == size) tail = 0;
+      used -= n;
+      room -= n;
+      frame_left -= n;
+      if (not frame_left) sent_frames++;
+    }
+  }
+
+  // drop everything queued, including a partly sent frame
+  void clear (void) {
+    head = tail = used = frame_left = 0;
+  }
+
+  size_t pending (void) const { return used; }  // bytes waiting, incl. headers
+  unsigned long sent (void) const { return sent_frames; }
+  unsigned long dropped (void) const { return dropped_frames; }
+
+ private:
+
+  void _put (const uint8_t* p, size_t n) {
+    size_t first = size - head;
+    if (first > n) first = n;
+    memcpy(ring + head, p, first);
+    memcpy(ring, p + first, n - first);
+    head += n;
+    if (head >= size) head -= size;
+    used += n;
+  }
+
+  uint8_t _take (void) {
+    uint8_t b = ring[tail];
+    if (++tail == size) tail = 0;
+    used--;
+    return b;
+  }
+
+  Stream&  os;
+  uint8_t* ring;
+  size_t   size;
+  size_t   head = 0, tail = 0, used = 0;
+  size_t   frame_left = 0;       // bytes of the current frame still to send
+  unsigned long sent_frames = 0, dropped_frames = 0;
+};
+
+#endif /* _H */
@@ -0,0 +1,138 @@
+#ifndef PLOT_SNAPSHOT_H
+#define PLOT_SNAPSHOT_H
+
+#include <Arduino.h>
+
+/*****************************************************************************
+ * PlotSnapshot - hand plot values from an interrupt handler to loop().
+ *
+ * Plot::add() isn't safe in an ISR, and reading a struct the ISR is busy
+ * filling can tear a frame. PlotSnapshot is a sequence lock: the ISR bumps
+ * a counter to odd, writes its values and bumps it back to even; loop()
+ * copies the values and retries if the counter moved meanwhile. The ISR
+ * never waits, nothing is allocated, and interrupts stay enabled.
+ *
+ * Usage:
+ *  PlotSnapshot<3> xyz({"x", "y", "z"});
+ *
+ *  void on_data (void) {           // ISR or ISR callback
+ *    xyz.begin();
+ *    xyz.set(0, x);  xyz.set(1, y);  xyz.set(2, z);
+ *    xyz.end();
+ *  }
+ *
+ *  void loop (void) {
+ *    if (xyz.add_to(plot)) plot.print(Serial);  // only when there's new data
+ *  }
+ *
+ * One writer only - a single ISR, or loop(). read() retries until the
+ * writer is done, so it must not run where it can interrupt the writer:
+ * if an ISR reads values that loop() writes, the ISR uses try_read(),
+ * which never waits, and skips the frame when it returns false.
+ *
+ * PLOT_BARRIER() is a full memory fence, so the writer and reader may
+ * also run on different cores (ESP32, RP2040).
+ *****************************************************************************/
+
+#ifdef __AVR__
+typedef uint8_t  plot_seq_t;   // must be read in one instruction
+#else
+typedef uint32_t plot_seq_t;
+#endif
+
+#if defined(__GNUC__)
+#define PLOT_BARRIER()  __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#else
+#define PLOT_BARRIER()  __asm__ __volatile__ ("" ::: "memory")
+#endif
+
+template <uint8_t N, typename T=float>
+class PlotSnapshot {
+ public:
+
+  PlotSnapshot (void) {
+    for (uint8_t i=0 ; i<N ; i++) labels[i] = "";
+  }
+
+  // labels are kept by pointer, so use literals or other static strings
+  PlotSnapshot (const char* const (&series_labels)[N]) {
+    for (uint8_t i=0 ; i<N ; i++) labels[i] = series_labels[i];
+  }
+
+  /*
+   * writer (ISR) side
+   */
+
+  void begin (void) {
+    seq = seq + 1;    // odd - update in progress
+    PLOT_BARRIER();
+  }
+
+  void set (uint8_t i, T value) {
+    if (i < N) values[i] = value;
+  }
+
+  void end (void) {
+    PLOT_BARRIER();
+    seq = seq + 1;    // even - consistent again
+  }
+
+  void write (const T (&new_values)[N]) {
+    begin();
+    for (uint8_t i=0 ; i<N ; i++) values[i] = new_values[i];
+    end();
+  }
+
+  /*
+   * reader (loop) side
+   */
+
+  // copy a consistent set of values, returns true if they're new since
+  // the last read; waits out a write in progress, so never call from an
+  // ISR that can interrupt the writer
+  bool read (T (&out)[N]) {
+    plot_seq_t got;
+    while (not _copy(out, got));
+    return _fresh(got);
+  }
+
+  // one attempt, never waits: returns true only for a consistent set of
+  // values that's new since the last read, else out may be torn
+  bool try_read (T (&out)[N]) {
+    plot_seq_t got;
+    return _copy(out, got) and _fresh(got);
+  }
+
+  // add new values to a plot with the constructor's labels
+  template <typename P>
+  bool add_to (P& plot) {
+    T snap[N];
+    if (not read(snap)) return false;
+    for (uint8_t i=0 ; i<N ; i++) plot.add(labels[i], snap[i]);
+    return true;
+  }
+
+ private:
+
+  bool _copy (T (&out)[N], plot_seq_t& got) {
+    plot_seq_t before = seq;
+    PLOT_BARRIER();
+    for (uint8_t i=0 ; i<N ; i++) out[i] = values[i];
+    PLOT_BARRIER();
+    got = seq;
+    return not (before & 1) and before == got;
+  }
+
+  bool _fresh (plot_seq_t got) {
+    bool fresh = (got != last_read);
+    last_read = got;
+    return fresh;
+  }
+
+  volatile T values[N];
+  volatile plot_seq_t seq = 0;
+  plot_seq_t last_read = 0;
+  const char* labels[N];
+};
+
+#endif /* _H */